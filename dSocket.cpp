@@ -2,23 +2,144 @@
 // Created by devilox on 12/17/20.
 //
 //-----------------------------//
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+//-----------------------------//
 #include "dSocket.h"
+#include "dSocketLogSink.h"
+#include "dSocketSendQueue.h"
+#include "dSocketCapture.h"
+//-----------------------------//
+constexpr int TimestampingFlags = SOF_TIMESTAMPING_RX_SOFTWARE |
+                                  SOF_TIMESTAMPING_TX_SOFTWARE |
+                                  SOF_TIMESTAMPING_SOFTWARE |
+                                  SOF_TIMESTAMPING_OPT_ID |
+                                  SOF_TIMESTAMPING_OPT_TSONLY;
+
+constexpr size_t DescriptorLimit = 64;
+//-----------------------------//
+uint64_t dSocketError::pack() const {
+    return (static_cast <uint64_t>(Result) << 48) |
+           (static_cast <uint64_t>(Operation) << 32) |
+           static_cast <uint32_t>(Errno);
+}
+dSocketError dSocketError::unpack(uint64_t tPacked) {
+    return {
+            .Result = static_cast <dSocketResult>(tPacked >> 48),
+            .Operation = static_cast <dSocketOperation>((tPacked >> 32) & 0xFFFF),
+            .Errno = static_cast <int32_t>(tPacked & 0xFFFFFFFF)
+    };
+}
+//-----------------------------//
+dSocketConnection::~dSocketConnection() {
+    close();
+}
+
+dSocketConnection::dSocketConnection(dSocketConnection&& tOther) noexcept :
+        mSocket(tOther.mSocket),
+        mStruct(tOther.mStruct) {
+    tOther.mSocket = -1;
+}
+dSocketConnection& dSocketConnection::operator=(dSocketConnection&& tOther) noexcept {
+    if (this != &tOther) {
+        close();
+
+        mSocket = tOther.mSocket;
+        mStruct = tOther.mStruct;
+
+        tOther.mSocket = -1;
+    }
+
+    return *this;
+}
+//-----------------------------//
+/**
+ * Function for taking the ownership of the socket away from the connection
+ * @return Socket fd, -1 if there was none
+ */
+int32_t dSocketConnection::release() {
+    int32_t Socket = mSocket;
+    mSocket = -1;
+
+    return Socket;
+}
+/**
+ * Function for closing the connection socket before the destruction
+ */
+void dSocketConnection::close() {
+    if (mSocket >= 0) {
+        ::close(mSocket);
+    }
+
+    mSocket = -1;
+}
 //-----------------------------//
 dSocket::~dSocket() {
-    if (mSocket != -1) {
-        shutdown(mSocket, 2);
-        close(mSocket);
+    closeSocket();
+
+    //---Do not leave the last failures to the flusher, the process may be about to exit---//
+
+    if (mVerbose && !mLogSink) {
+        dSocketLogSink::instance().flush(std::cerr);
+    }
+}
+
+dSocket::dSocket(dSocket&& tOther) noexcept :
+        mSocket(tOther.mSocket),
+        mStruct(tOther.mStruct),
+        mStructSize(tOther.mStructSize),
+        mType(tOther.mType),
+        mProtocol(tOther.mProtocol),
+        mVerbose(tOther.mVerbose),
+        mBacklog(tOther.mBacklog),
+        mTimestampingPending(tOther.mTimestampingPending),
+        mOwnsPath(tOther.mOwnsPath),
+        mProfile(std::move(tOther.mProfile)),
+        mLogSink(tOther.mLogSink),
+        mCapture(tOther.mCapture),
+        mLastError(tOther.mLastError.load(std::memory_order_relaxed)) {
+    tOther.mSocket      = -1;
+    tOther.mOwnsPath    = false;
+    tOther.mType        = dSocketType::UNDEFINED;
+    tOther.mProtocol    = dSocketProtocol::UNDEFINED;
+}
+dSocket& dSocket::operator=(dSocket&& tOther) noexcept {
+    if (this != &tOther) {
+        closeSocket();
+
+        mSocket     = tOther.mSocket;
+        mStruct     = tOther.mStruct;
+        mStructSize = tOther.mStructSize;
+        mType       = tOther.mType;
+        mProtocol   = tOther.mProtocol;
+        mVerbose    = tOther.mVerbose;
+        mBacklog    = tOther.mBacklog;
+        mProfile    = std::move(tOther.mProfile);
+        mLogSink    = tOther.mLogSink;
+        mCapture    = tOther.mCapture;
+
+        mTimestampingPending = tOther.mTimestampingPending;
+        mOwnsPath            = tOther.mOwnsPath;
+
+        mLastError.store(tOther.mLastError.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+        tOther.mSocket      = -1;
+        tOther.mOwnsPath    = false;
+        tOther.mType        = dSocketType::UNDEFINED;
+        tOther.mProtocol    = dSocketProtocol::UNDEFINED;
     }
 
-    mSocket = 0;
+    return *this;
 }
 //-----------------------------//
 /**
  * Function for initial socket creation
- * @param tProtocol Specified protocol (TCP / UDP)
+ * @param tProtocol Specified protocol (TCP / UDP / Unix stream / Unix datagram)
  * @return Status
  */
 dSocketResult dSocket::init(dSocketProtocol tProtocol) {
+    closeSocket();
     mProtocol = tProtocol;
 
     switch (tProtocol) {
@@ -28,17 +149,24 @@ dSocketResult dSocket::init(dSocketProtocol tProtocol) {
         case dSocketProtocol::UDP:
             mSocket = socket(AF_INET, SOCK_DGRAM, 0);
             break;
+        case dSocketProtocol::UNIX_STREAM:
+            mSocket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            break;
+        case dSocketProtocol::UNIX_DGRAM:
+            mSocket = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+            break;
         case dSocketProtocol::UNDEFINED:
             return dSocketResult::WRONG_PROTOCOL;
     }
 
     if (mSocket < 0) {
-        if (mVerbose) {
-            mLastErrno = errno;
-            std::cerr << "dSocket::init" << std::endl;
-        }
+        return reportError(dSocketOperation::INIT, dSocketResult::CREATE_FAILURE, errno);
+    }
 
-        return dSocketResult::CREATE_FAILURE;
+    //---Options that could not be set are recorded as failures, the socket is usable anyway---//
+
+    if (mProfile) {
+        applyOptionProfile(mSocket);
     }
 
     return dSocketResult::SUCCESS;
@@ -60,12 +188,7 @@ dSocketResult dSocket::setNoDelayOption(bool tEnable) {
     int Flag = static_cast <int>(tEnable);
 
     if (setsockopt(mSocket, IPPROTO_TCP, TCP_NODELAY, &Flag, sizeof(Flag)) == -1) {
-        if (mVerbose) {
-            mLastErrno = errno;
-            std::cerr << "dSocket::setNoDelayOption" << std::endl;
-        }
-
-        return dSocketResult::SET_OPTION_FAILURE;
+        return reportError(dSocketOperation::SET_OPTION, dSocketResult::SET_OPTION_FAILURE, errno);
     }
 
     return dSocketResult::SUCCESS;
@@ -80,82 +203,370 @@ dSocketResult dSocket::setReuseOption(bool tEnable) {
     int Flag = static_cast <int>(tEnable);
 
     if (setsockopt(mSocket, SOL_SOCKET, SO_REUSEADDR, &Flag, sizeof(Flag)) == -1) {
-        if (mVerbose) {
-            mLastErrno = errno;
-            std::cerr << "dSocket::setReuseOption" << std::endl;
-        }
+        return reportError(dSocketOperation::SET_OPTION, dSocketResult::SET_OPTION_FAILURE, errno);
+    }
+
+    return dSocketResult::SUCCESS;
+}
+
+/**
+ * Function for waking up the server only when the client has sent data, so that accepted
+ * connections are immediately readable (TCP_DEFER_ACCEPT)
+ * @param tTimeoutSec Time to wait for the first data (0 to disable)
+ * @return Status
+ */
+dSocketResult dSocket::setDeferAcceptOption(uint32_t tTimeoutSec) {
+    if (mProtocol != dSocketProtocol::TCP) {
+        return dSocketResult::WRONG_PROTOCOL;
+    }
+
+    //----------//
+
+    int Value = static_cast <int>(tTimeoutSec);
+
+    if (setsockopt(mSocket, IPPROTO_TCP, TCP_DEFER_ACCEPT, &Value, sizeof(Value)) == -1) {
+        return reportError(dSocketOperation::SET_OPTION, dSocketResult::SET_OPTION_FAILURE, errno);
+    }
+
+    return dSocketResult::SUCCESS;
+}
+/**
+ * Function for enabling TCP Fast Open on the server socket, allowing data in the SYN
+ * of repeated connections. Must be called before finalize
+ * @param tQueueLength Maximum number of pending TFO requests (0 to disable)
+ * @return Status
+ */
+dSocketResult dSocket::setFastOpenOption(int tQueueLength) {
+    if (mProtocol != dSocketProtocol::TCP) {
+        return dSocketResult::WRONG_PROTOCOL;
+    }
+
+    //----------//
+
+    if (setsockopt(mSocket, IPPROTO_TCP, TCP_FASTOPEN, &tQueueLength, sizeof(tQueueLength)) == -1) {
+        return reportError(dSocketOperation::SET_OPTION, dSocketResult::SET_OPTION_FAILURE, errno);
+    }
+
+    return dSocketResult::SUCCESS;
+}
+/**
+ * Function for enabling kernel software timestamps of received data (returned by the
+ * timestamped read functions) and of sent data (returned by readTxTimestamp). On a TCP
+ * socket that is not connected yet the option is applied by connectToServer; on a stream
+ * server it is applied to every accepted socket
+ * @param tEnable Flag
+ * @return Status
+ */
+dSocketResult dSocket::setTimestampingOption(bool tEnable) {
+    int Errno = setTimestamping(mSocket, tEnable);
+
+    if (Errno) {
+        return reportError(dSocketOperation::SET_OPTION, dSocketResult::SET_OPTION_FAILURE, Errno);
+    }
+
+    return dSocketResult::SUCCESS;
+}
+/**
+ * Function for enabling or disabling delivery of sent multicast datagrams back to the local
+ * sockets joined to the group (enabled by default)
+ * @param tEnable Flag
+ * @return Status
+ */
+dSocketResult dSocket::setMulticastLoopOption(bool tEnable) {
+    if (mProtocol != dSocketProtocol::UDP) {
+        return dSocketResult::WRONG_PROTOCOL;
+    }
+
+    //----------//
+
+    auto Flag = static_cast <uint8_t>(tEnable);
+
+    if (setsockopt(mSocket, IPPROTO_IP, IP_MULTICAST_LOOP, &Flag, sizeof(Flag)) == -1) {
+        return reportError(dSocketOperation::SET_OPTION, dSocketResult::SET_OPTION_FAILURE, errno);
+    }
+
+    return dSocketResult::SUCCESS;
+}
+/**
+ * Function for setting the TTL of sent multicast datagrams (1 by default, local network only)
+ * @param tTtl Time to live
+ * @return Status
+ */
+dSocketResult dSocket::setMulticastTtlOption(uint8_t tTtl) {
+    if (mProtocol != dSocketProtocol::UDP) {
+        return dSocketResult::WRONG_PROTOCOL;
+    }
+
+    //----------//
+
+    if (setsockopt(mSocket, IPPROTO_IP, IP_MULTICAST_TTL, &tTtl, sizeof(tTtl)) == -1) {
+        return reportError(dSocketOperation::SET_OPTION, dSocketResult::SET_OPTION_FAILURE, errno);
+    }
+
+    return dSocketResult::SUCCESS;
+}
+/**
+ * Function for selecting the local interface multicast datagrams are sent from
+ * @param tInterfaceAddress IPv4 address of the interface
+ * @return Status
+ */
+dSocketResult dSocket::setMulticastInterfaceOption(const std::string& tInterfaceAddress) {
+    if (mProtocol != dSocketProtocol::UDP) {
+        return dSocketResult::WRONG_PROTOCOL;
+    }
+
+    //----------//
+
+    in_addr Interface = {};
 
-        return dSocketResult::SET_OPTION_FAILURE;
+    if (inet_pton(AF_INET, tInterfaceAddress.data(), &Interface) <= 0) {
+        return reportError(dSocketOperation::SET_OPTION, dSocketResult::ADDRESS_CONVERSION_FAILURE, errno);
+    }
+
+    if (setsockopt(mSocket, IPPROTO_IP, IP_MULTICAST_IF, &Interface, sizeof(Interface)) == -1) {
+        return reportError(dSocketOperation::SET_OPTION, dSocketResult::SET_OPTION_FAILURE, errno);
     }
 
     return dSocketResult::SUCCESS;
 }
+/**
+ * Function for setting the accept queue length used by finalize (SOMAXCONN by default).
+ * Must be called before finalize
+ * @param tBacklog Accept queue length
+ */
+void dSocket::setListenBacklog(int tBacklog) {
+    mBacklog = tBacklog;
+}
+
+/**
+ * Function for storing an option profile. The profile is applied to the socket right away
+ * if it is already created (otherwise in init) and to every accepted connection. Options
+ * that do not apply to the protocol (e.g. TCP options on a UDP socket) are skipped and
+ * reported as WRONG_PROTOCOL without failing the call
+ * @param tProfile Option profile
+ * @param tStatus Optional per-option report
+ * @return Status (SET_OPTION_FAILURE if at least one applicable option was not applied)
+ */
+dSocketResult dSocket::setOptionProfile(const dSocketOptionProfile& tProfile, std::vector <dSocketOptionStatus>* tStatus) {
+    mProfile = tProfile;
+
+    if (mSocket < 0) {
+        return dSocketResult::SUCCESS;
+    }
+
+    return applyOptionProfile(mSocket, tStatus);
+}
+/**
+ * Function for applying the stored option profile to the specified socket. Options that do
+ * not apply to the protocol are skipped
+ * @param tSocket Socket (this socket or an accepted one)
+ * @param tStatus Optional per-option report (skipped options are marked WRONG_PROTOCOL)
+ * @return Status (SET_OPTION_FAILURE if at least one applicable option was not applied)
+ */
+dSocketResult dSocket::applyOptionProfile(int tSocket, std::vector <dSocketOptionStatus>* tStatus) {
+    if (!mProfile) {
+        return dSocketResult::SUCCESS;
+    }
+
+    //----------//
+
+    dSocketResult Result = dSocketResult::SUCCESS;
+
+    auto Apply = [&](dSocketOption tOption, bool tTcpOnly, int tLevel, int tName, int tValue) {
+        dSocketOptionStatus Status {
+                .Option = tOption,
+                .Result = dSocketResult::SUCCESS,
+                .Errno = 0
+        };
+
+        if (tTcpOnly && mProtocol != dSocketProtocol::TCP) {
+            Status.Result = dSocketResult::WRONG_PROTOCOL;          //---Skipped, not a failure---//
+        } else if (setsockopt(tSocket, tLevel, tName, &tValue, sizeof(tValue)) == -1) {
+            Status.Result = dSocketResult::SET_OPTION_FAILURE;
+            Status.Errno = errno;
+
+            Result = reportError(dSocketOperation::SET_OPTION, dSocketResult::SET_OPTION_FAILURE, errno);
+        }
+
+        if (tStatus) {
+            tStatus -> push_back(Status);
+        }
+    };
+
+    const dSocketOptionProfile& Profile = *mProfile;
+
+    if (Profile.ReceiveBuffer) {
+        Apply(dSocketOption::RECEIVE_BUFFER, false, SOL_SOCKET, SO_RCVBUF, *Profile.ReceiveBuffer);
+    }
+
+    if (Profile.SendBuffer) {
+        Apply(dSocketOption::SEND_BUFFER, false, SOL_SOCKET, SO_SNDBUF, *Profile.SendBuffer);
+    }
+
+    if (Profile.BusyPoll) {
+        Apply(dSocketOption::BUSY_POLL, false, SOL_SOCKET, SO_BUSY_POLL, *Profile.BusyPoll);
+    }
+
+    if (Profile.IncomingCpu) {
+        Apply(dSocketOption::INCOMING_CPU, false, SOL_SOCKET, SO_INCOMING_CPU, *Profile.IncomingCpu);
+    }
+
+    if (Profile.QuickAck) {
+        Apply(dSocketOption::QUICK_ACK, true, IPPROTO_TCP, TCP_QUICKACK, static_cast <int>(*Profile.QuickAck));
+    }
+
+    if (Profile.NotSentLowAt) {
+        Apply(dSocketOption::NOT_SENT_LOW_AT, true, IPPROTO_TCP, TCP_NOTSENT_LOWAT, *Profile.NotSentLowAt);
+    }
+
+    if (Profile.Priority) {
+        Apply(dSocketOption::PRIORITY, false, SOL_SOCKET, SO_PRIORITY, *Profile.Priority);
+    }
+
+    if (Profile.NoDelay) {
+        Apply(dSocketOption::NO_DELAY, true, IPPROTO_TCP, TCP_NODELAY, static_cast <int>(*Profile.NoDelay));
+    }
+
+    if (Profile.Timestamping) {
+        int Errno = setTimestamping(tSocket, *Profile.Timestamping);
+
+        if (Errno) {
+            Result = reportError(dSocketOperation::SET_OPTION, dSocketResult::SET_OPTION_FAILURE, Errno);
+        }
+
+        if (tStatus) {
+            tStatus -> push_back({
+                    .Option = dSocketOption::TIMESTAMPING,
+                    .Result = Errno ? dSocketResult::SET_OPTION_FAILURE : dSocketResult::SUCCESS,
+                    .Errno = Errno
+            });
+        }
+    }
+
+    return Result;
+}
 
 /**
  * Function for filling socket structures and, in case of server, binding to the specified
- * port
+ * port. Unix sockets use a path instead of the port, a path starting with '@' is placed in
+ * the abstract namespace. A Unix server replaces only a stale socket file at its path (fails
+ * with BIND_FAILURE / EADDRINUSE otherwise, see removeStalePath) and removes the file when
+ * closed
  * @param tType Server or client
- * @param tPort Port
- * @param tServerAddress Address to connect to (ignored in case of server type)
+ * @param tPort Port (ignored in case of Unix sockets)
+ * @param tServerAddress Address to connect to (ignored in case of server type), or the socket
+ * path in case of Unix sockets
  * @return Status
  */
 dSocketResult dSocket::finalize(dSocketType tType, uint16_t tPort, const std::string& tServerAddress) {
     if (mProtocol == dSocketProtocol::UNDEFINED) {
-        if (mVerbose) {
-            std::cerr << "dSocket::finalize" << std::endl;
-        }
-
-        return dSocketResult::WRONG_PROTOCOL;
+        return reportError(dSocketOperation::FINALIZE, dSocketResult::WRONG_PROTOCOL);
     }
 
     //----------//
 
     mType = tType;
 
+    if (tType == dSocketType::UNDEFINED) {
+        return reportError(dSocketOperation::FINALIZE, dSocketResult::NO_SOCKET_TYPE);
+    }
+
+    bool Unix = mProtocol == dSocketProtocol::UNIX_STREAM || mProtocol == dSocketProtocol::UNIX_DGRAM;
+
+    if (Unix) {
+        auto* Struct = reinterpret_cast <sockaddr_un*>(&mStruct);
+
+        if (tServerAddress.empty() || tServerAddress.size() >= sizeof(Struct -> sun_path)) {
+            return reportError(dSocketOperation::FINALIZE, dSocketResult::ADDRESS_CONVERSION_FAILURE, ENAMETOOLONG);
+        }
+
+        mStruct = {};
+        Struct -> sun_family = AF_UNIX;
+
+        if (tServerAddress[0] == '@') {
+            tServerAddress.copy(Struct -> sun_path + 1, tServerAddress.size() - 1, 1);
+            mStructSize = offsetof(sockaddr_un, sun_path) + tServerAddress.size();
+        } else {
+            tServerAddress.copy(Struct -> sun_path, tServerAddress.size());
+            mStructSize = sizeof(sockaddr_un);
+        }
+    }
+
     switch (tType) {
         case dSocketType::UNDEFINED:
-            if (mVerbose) {
-                std::cerr << "dSocket::finalize" << std::endl;
-            }
-
-            return dSocketResult::NO_SOCKET_TYPE;
+            break;
         case dSocketType::SERVER:
-            mStruct.sin_family          = AF_INET;
-            mStruct.sin_addr.s_addr     = INADDR_ANY;
-            mStruct.sin_port            = htons(tPort);
-
-            if (bind(mSocket, (struct sockaddr*)&mStruct, sizeof(mStruct)) == -1) {
-                if (mVerbose) {
-                    mLastErrno = errno;
-                    std::cerr << "dSocket::finalize" << std::endl;
+            if (Unix) {
+                auto* Struct = reinterpret_cast <sockaddr_un*>(&mStruct);
+
+                //---Remove the file left by a dead server bound to the same path, never anything else---//
+
+                if (Struct -> sun_path[0] != '\0') {
+                    int Errno = removeStalePath(Struct);
+
+                    if (Errno) {
+                        return reportError(dSocketOperation::FINALIZE, dSocketResult::BIND_FAILURE, Errno);
+                    }
                 }
+            } else {
+                auto* Struct = reinterpret_cast <sockaddr_in*>(&mStruct);
+
+                Struct -> sin_family        = AF_INET;
+                Struct -> sin_addr.s_addr   = INADDR_ANY;
+                Struct -> sin_port          = htons(tPort);
 
-                return dSocketResult::BIND_FAILURE;
+                mStructSize = sizeof(sockaddr_in);
             }
 
-            if (mProtocol == dSocketProtocol::TCP) {
-                if (listen(mSocket, 1) == -1) {
-                    if (mVerbose) {
-                        mLastErrno = errno;
-                        std::cerr << "dSocket::finalize" << std::endl;
-                    }
+            if (bind(mSocket, (struct sockaddr*)&mStruct, mStructSize) == -1) {
+                return reportError(dSocketOperation::FINALIZE, dSocketResult::BIND_FAILURE, errno);
+            }
+
+            mOwnsPath = Unix && reinterpret_cast <sockaddr_un*>(&mStruct) -> sun_path[0] != '\0';
+
+            if (isStreamProtocol(mProtocol)) {
+                if (listen(mSocket, mBacklog) == -1) {
+                    return reportError(dSocketOperation::FINALIZE, dSocketResult::LISTEN_FAILURE, errno);
+                }
+
+                //---Listening socket is non-blocking so the accept loop can drain the queue---//
+                //---acceptConnection keeps blocking semantics by polling first---//
+
+                int Flags;
+
+                if ((Flags = fcntl(mSocket, F_GETFL, nullptr)) < 0) {
+                    return reportError(dSocketOperation::FINALIZE, dSocketResult::GET_FLAGS_FAILURE, errno);
+                }
 
-                    return dSocketResult::LISTEN_FAILURE;
+                if (fcntl(mSocket, F_SETFL, Flags | O_NONBLOCK) < 0) {
+                    return reportError(dSocketOperation::FINALIZE, dSocketResult::SET_FLAGS_FAILURE, errno);
                 }
             }
 
             break;
         case dSocketType::CLIENT:
-            mStruct.sin_family          = AF_INET;
-            mStruct.sin_port            = htons(tPort);
+            if (Unix) {
+                //---Unix datagram client needs an address of its own to receive replies---//
+
+                if (mProtocol == dSocketProtocol::UNIX_DGRAM) {
+                    sockaddr_un Struct = {};
+                    Struct.sun_family = AF_UNIX;
+
+                    if (bind(mSocket, (struct sockaddr*)&Struct, sizeof(sa_family_t)) == -1) {
+                        return reportError(dSocketOperation::FINALIZE, dSocketResult::BIND_FAILURE, errno);
+                    }
+                }
+            } else {
+                auto* Struct = reinterpret_cast <sockaddr_in*>(&mStruct);
+
+                Struct -> sin_family        = AF_INET;
+                Struct -> sin_port          = htons(tPort);
 
-            if (inet_pton(AF_INET, tServerAddress.data(), &mStruct.sin_addr) <= 0) {
-                if (mVerbose) {
-                    mLastErrno = errno;
-                    std::cerr << "dSocket::finalize" << std::endl;
+                if (inet_pton(AF_INET, tServerAddress.data(), &Struct -> sin_addr) <= 0) {
+                    return reportError(dSocketOperation::FINALIZE, dSocketResult::ADDRESS_CONVERSION_FAILURE, errno);
                 }
 
-                return dSocketResult::ADDRESS_CONVERSION_FAILURE;
+                mStructSize = sizeof(sockaddr_in);
             }
 
             break;
@@ -168,469 +579,1500 @@ dSocketResult dSocket::finalize(dSocketType tType, uint16_t tPort, const std::st
  * @return Unlike other functions this one must return client socket fd, -1 otherwise
  */
 int dSocket::acceptConnection() {
-    socklen_t StructSize = sizeof(mStruct);
+    sockaddr_in Struct = {};
+    socklen_t StructSize;
     int Socket;
 
-    if ((Socket = accept(mSocket, (struct sockaddr*)&mStruct, &StructSize)) == -1) {
-        if (mVerbose) {
-            mLastErrno = errno;
-            std::cerr << "dSocket::acceptConnection" << std::endl;
+    while (true) {
+        if (waitForConnection(-1) != dSocketResult::SUCCESS) {
+            return -1;
         }
-    }
 
-    return Socket;
+        StructSize = mProtocol == dSocketProtocol::TCP ? sizeof(Struct) : 0;     //---Unix peer addresses are not kept---//
+
+        if ((Socket = accept4(mSocket, (struct sockaddr*)&Struct, &StructSize, SOCK_CLOEXEC)) == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+
+            reportError(dSocketOperation::ACCEPT, dSocketResult::ACCEPT_FAILURE, errno);
+        } else {
+            prepareAcceptedSocket(Socket);
+        }
+
+        return Socket;
+    }
 }
 /**
- * Function for connecting to server, also sets the socket to non-blocking mode
- * @param tTimeoutMs Select timeout value
+ * Function for accepting a single connection into an owning handle. Unlike acceptConnection()
+ * it can time out
+ * @param tConnection Connection handle to fill
+ * @param tTimeoutMs Wait timeout (-1 to wait indefinitely)
  * @return Status
  */
-dSocketResult dSocket::connectToServer(uint32_t tTimeoutMs) {
-    if (mProtocol != dSocketProtocol::TCP) {
-        if (mVerbose) {
-            std::cerr << "dSocket::connectToServer" << std::endl;
-        }
+dSocketResult dSocket::acceptConnection(dSocketConnection* tConnection, int tTimeoutMs) {
+    if (mType != dSocketType::SERVER) {
+        return reportError(dSocketOperation::ACCEPT, dSocketResult::WRONG_SOCKET_TYPE);
+    }
 
-        return dSocketResult::WRONG_PROTOCOL;
+    if (!isStreamProtocol(mProtocol)) {
+        return reportError(dSocketOperation::ACCEPT, dSocketResult::WRONG_PROTOCOL);
     }
 
-    if (mType == dSocketType::SERVER) {
-        if (mVerbose) {
-            std::cerr << "dSocket::connectToServer" << std::endl;
+    //----------//
+
+    sockaddr_in Struct = {};
+    socklen_t StructSize;
+    int Socket;
+
+    while (true) {
+        dSocketResult Result = waitForConnection(tTimeoutMs);
+
+        if (Result != dSocketResult::SUCCESS) {
+            return Result;
         }
 
-        return dSocketResult::WRONG_SOCKET_TYPE;
-    }
+        StructSize = mProtocol == dSocketProtocol::TCP ? sizeof(Struct) : 0;     //---Unix peer addresses are not kept---//
 
-#if __linux__
-    int Result;
-    int Flags;
-    timeval Timeout {
-            .tv_sec = tTimeoutMs / 1000,
-            .tv_usec = tTimeoutMs % 1000 * 1000
-    };
+        if ((Socket = accept4(mSocket, (struct sockaddr*)&Struct, &StructSize, SOCK_CLOEXEC)) == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
 
-    if ((Flags = fcntl(mSocket, F_GETFL, nullptr)) < 0) {
-        if (mVerbose) {
-            mLastErrno = errno;
-            std::cerr << "dSocket::connectToServer" << std::endl;
+            return reportError(dSocketOperation::ACCEPT, dSocketResult::ACCEPT_FAILURE, errno);
         }
 
-        return dSocketResult::GET_FLAGS_FAILURE;
+        prepareAcceptedSocket(Socket);
+        *tConnection = dSocketConnection(Socket, Struct);
+
+        return dSocketResult::SUCCESS;
+    }
+}
+/**
+ * Function for draining the whole accept queue in one call. Waits for at least one pending
+ * connection, then accepts until the queue is empty. Accepted sockets are non-blocking and
+ * close-on-exec
+ * @param tConnections Vector the accepted connections are appended to
+ * @param tTimeoutMs Wait timeout (-1 to wait indefinitely, 0 to only drain what is pending)
+ * @return Status
+ */
+dSocketResult dSocket::acceptConnections(std::vector <dSocketConnection>* tConnections, int tTimeoutMs) {
+    if (mType != dSocketType::SERVER) {
+        return reportError(dSocketOperation::ACCEPT, dSocketResult::WRONG_SOCKET_TYPE);
+    }
+
+    if (!isStreamProtocol(mProtocol)) {
+        return reportError(dSocketOperation::ACCEPT, dSocketResult::WRONG_PROTOCOL);
     }
 
-    if (fcntl(mSocket, F_SETFL, Flags | O_NONBLOCK) < 0) {
-        if (mVerbose) {
-            mLastErrno = errno;
-            std::cerr << "dSocket::connectToServer" << std::endl;
-        }
+    //----------//
 
-        return dSocketResult::SET_FLAGS_FAILURE;
+    dSocketResult Result = waitForConnection(tTimeoutMs);
+
+    if (Result != dSocketResult::SUCCESS) {
+        return Result;
     }
 
-    if ((Result = connect(mSocket, (struct sockaddr*)&mStruct, sizeof(mStruct))) < 0) {
-        if (errno == EINPROGRESS) {
-            fd_set WaitSet;
+    sockaddr_in Struct = {};
+    socklen_t StructSize;
+    int Socket;
+
+    while (true) {
+        StructSize = mProtocol == dSocketProtocol::TCP ? sizeof(Struct) : 0;     //---Unix peer addresses are not kept---//
+
+        if ((Socket = accept4(mSocket, (struct sockaddr*)&Struct, &StructSize, SOCK_NONBLOCK | SOCK_CLOEXEC)) == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+
+            return reportError(dSocketOperation::ACCEPT, dSocketResult::ACCEPT_FAILURE, errno);
+        }
+
+        prepareAcceptedSocket(Socket);
+        tConnections -> emplace_back(Socket, Struct);
+    }
+
+    return dSocketResult::SUCCESS;
+}
+/**
+ * Function for connecting to server, also sets the socket to non-blocking mode
+ * @param tTimeoutMs Select timeout value
+ * @return Status
+ */
+dSocketResult dSocket::connectToServer(uint32_t tTimeoutMs) {
+    if (!isStreamProtocol(mProtocol)) {
+        return reportError(dSocketOperation::CONNECT, dSocketResult::WRONG_PROTOCOL);
+    }
+
+    if (mType == dSocketType::SERVER) {
+        return reportError(dSocketOperation::CONNECT, dSocketResult::WRONG_SOCKET_TYPE);
+    }
+
+#if __linux__
+    int Result;
+    int Flags;
+    timeval Timeout {
+            .tv_sec = tTimeoutMs / 1000,
+            .tv_usec = tTimeoutMs % 1000 * 1000
+    };
+
+    if ((Flags = fcntl(mSocket, F_GETFL, nullptr)) < 0) {
+        return reportError(dSocketOperation::CONNECT, dSocketResult::GET_FLAGS_FAILURE, errno);
+    }
+
+    if (fcntl(mSocket, F_SETFL, Flags | O_NONBLOCK) < 0) {
+        return reportError(dSocketOperation::CONNECT, dSocketResult::SET_FLAGS_FAILURE, errno);
+    }
+
+    if ((Result = connect(mSocket, (struct sockaddr*)&mStruct, mStructSize)) < 0) {
+        if (errno == EINPROGRESS) {
+            fd_set WaitSet;
+
+            FD_ZERO(&WaitSet);
+            FD_SET(mSocket, &WaitSet);
+
+            Result = select(mSocket + 1, nullptr, &WaitSet, nullptr, &Timeout);
+        }
+    } else {
+        Result = 1;
+    }
+
+    if (fcntl(mSocket, F_SETFL, Flags) < 0) {
+        return reportError(dSocketOperation::CONNECT, dSocketResult::SET_FLAGS_FAILURE, errno);
+    }
+
+    if (Result < 0) {
+        return reportError(dSocketOperation::CONNECT, dSocketResult::CONNECTION_FAILURE, errno);
+    } else if (Result == 0) {
+        return reportError(dSocketOperation::CONNECT, dSocketResult::CONNECTION_TIMEOUT, ETIMEDOUT);
+    } else {
+        socklen_t Length = sizeof(Flags);
+
+        if (getsockopt(mSocket, SOL_SOCKET, SO_ERROR, &Flags, &Length) < 0) {
+            return reportError(dSocketOperation::CONNECT, dSocketResult::GET_OPTION_FAILURE, errno);
+        }
+
+        if (Flags) {
+            switch (Flags) {
+                case ECONNREFUSED:
+                    return reportError(dSocketOperation::CONNECT, dSocketResult::CONNECTION_REFUSED, Flags);
+                case EHOSTUNREACH:
+                    return reportError(dSocketOperation::CONNECT, dSocketResult::HOST_UNREACHABLE, Flags);
+                default:
+                    return reportError(dSocketOperation::CONNECT, dSocketResult::UNKNOWN, Flags);
+            }
+        }
+    }
+
+    if (mTimestampingPending) {
+        int Errno = setTimestamping(mSocket, true);
+
+        if (Errno) {
+            return reportError(dSocketOperation::CONNECT, dSocketResult::SET_OPTION_FAILURE, Errno);
+        }
+    }
+
+    if (mCapture) {
+        mCapture -> record(dSocketOperation::CONNECT, mSocket, 0);
+    }
+#elif _WIN32
+    if (connect(mClientSocket, (struct sockaddr*)&mClientStruct, sizeof(mClientStruct)) < 0) {
+        throw dSocketException(dSocketException::CONNECT_ERROR, strerror(errno));
+    }
+
+    ///---DO SOMETHING---///
+#endif
+
+    return dSocketResult::SUCCESS;
+}
+/**
+ * Function for subscribing the UDP socket to a multicast group. The socket should be bound
+ * to the group port (server type)
+ * @param tGroupAddress Multicast group address
+ * @param tInterfaceAddress Local interface address (any interface if empty)
+ * @return Status
+ */
+dSocketResult dSocket::joinMulticastGroup(const std::string& tGroupAddress, const std::string& tInterfaceAddress) {
+    return changeMembership(IP_ADD_MEMBERSHIP, tGroupAddress, tInterfaceAddress);
+}
+/**
+ * Function for unsubscribing the UDP socket from a multicast group
+ * @param tGroupAddress Multicast group address
+ * @param tInterfaceAddress Local interface address (any interface if empty)
+ * @return Status
+ */
+dSocketResult dSocket::leaveMulticastGroup(const std::string& tGroupAddress, const std::string& tInterfaceAddress) {
+    return changeMembership(IP_DROP_MEMBERSHIP, tGroupAddress, tInterfaceAddress);
+}
+/**
+ * Function for creating a pair of connected Unix sockets, both usable as clients with the
+ * regular read / write functions (readTCP / writeTCP for UNIX_STREAM, readUDP / writeUDP
+ * for UNIX_DGRAM)
+ * @param tProtocol UNIX_STREAM or UNIX_DGRAM
+ * @param tFirst First end
+ * @param tSecond Second end
+ * @return Status
+ */
+dSocketResult dSocket::createPair(dSocketProtocol tProtocol, dSocket* tFirst, dSocket* tSecond) {
+    int Type;
+
+    switch (tProtocol) {
+        case dSocketProtocol::UNIX_STREAM:
+            Type = SOCK_STREAM;
+            break;
+        case dSocketProtocol::UNIX_DGRAM:
+            Type = SOCK_DGRAM;
+            break;
+        default:
+            return tFirst -> reportError(dSocketOperation::INIT, dSocketResult::WRONG_PROTOCOL);
+    }
+
+    int Sockets[2];
+
+    if (socketpair(AF_UNIX, Type | SOCK_CLOEXEC, 0, Sockets) == -1) {
+        return tFirst -> reportError(dSocketOperation::INIT, dSocketResult::CREATE_FAILURE, errno);
+    }
+
+    dSocket* Ends[2] = {tFirst, tSecond};
+    dSocketResult Result = dSocketResult::SUCCESS;
+
+    for (int i = 0; i < 2; i++) {
+        Ends[i] -> closeSocket();
+
+        Ends[i] -> mSocket      = Sockets[i];
+        Ends[i] -> mProtocol    = tProtocol;
+        Ends[i] -> mType        = dSocketType::CLIENT;
+        Ends[i] -> mStruct      = {};
+        Ends[i] -> mStructSize  = 0;
+
+        if (Ends[i] -> mProfile && Ends[i] -> applyOptionProfile(Sockets[i]) != dSocketResult::SUCCESS) {
+            Result = dSocketResult::SET_OPTION_FAILURE;
+        }
+    }
+
+    return Result;
+}
+//-----------------------------//
+/**
+ * Function for reading data from the TCP socket
+ * @param tDstBuffer Buffer to put data into
+ * @param tBufferSize Buffer size
+ * @param tReadBytes Number of bytes actually received
+ * @param tError Failure details, filled only on failure (optional)
+ * @return Status
+ */
+dSocketResult dSocket::readTCP(uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes, dSocketError* tError) {
+    if (mType != dSocketType::CLIENT) {
+        return reportError(dSocketOperation::READ_TCP, dSocketResult::WRONG_SOCKET_TYPE, 0, tError);
+    }
+
+
+    if (!isStreamProtocol(mProtocol)) {
+        return reportError(dSocketOperation::READ_TCP, dSocketResult::WRONG_PROTOCOL, 0, tError);
+    }
+
+    //----------//
+
+    ssize_t ReadBytes;
+
+    if ((ReadBytes = recv(mSocket, tDstBuffer, tBufferSize, 0)) == -1) {
+        return reportError(dSocketOperation::READ_TCP, dSocketResult::READ_ERROR, errno, tError);
+    }
+
+    if (mCapture) {
+        mCapture -> record(dSocketOperation::READ_TCP, mSocket, ReadBytes);
+    }
+
+    *tReadBytes = ReadBytes;
+    return dSocketResult::SUCCESS;
+}
+/**
+ * Function for writing data to the TCP socket
+ * @param tSrcBuffer Buffer with the data to send
+ * @param tBufferSize Buffer size
+ * @param tWrittenBytes Number of bytes actually written
+ * @param tError Failure details, filled only on failure (optional)
+ * @return Status
+ */
+dSocketResult dSocket::writeTCP(const uint8_t* tSrcBuffer, size_t tBufferSize, ssize_t* tWrittenBytes, dSocketError* tError) {
+    if (mType != dSocketType::CLIENT) {
+        return reportError(dSocketOperation::WRITE_TCP, dSocketResult::WRONG_SOCKET_TYPE, 0, tError);
+    }
+
+
+    if (!isStreamProtocol(mProtocol)) {
+        return reportError(dSocketOperation::WRITE_TCP, dSocketResult::WRONG_PROTOCOL, 0, tError);
+    }
+
+    //----------//
+
+    ssize_t WrittenBytes;
+
+    if ((WrittenBytes = send(mSocket, tSrcBuffer, tBufferSize, MSG_NOSIGNAL)) == -1) {
+        return reportError(dSocketOperation::WRITE_TCP, dSocketResult::WRITE_ERROR, errno, tError);
+    }
+
+    if (mCapture) {
+        mCapture -> record(dSocketOperation::WRITE_TCP, mSocket, WrittenBytes);
+    }
+
+    *tWrittenBytes = WrittenBytes;
+    return dSocketResult::SUCCESS;
+}
+
+
+
+dSocketResult dSocket::readTCP(int tSocket, uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes, dSocketError* tError) {
+    if (mType != dSocketType::SERVER) {
+        return reportError(dSocketOperation::READ_TCP, dSocketResult::WRONG_SOCKET_TYPE, 0, tError);
+    }
+
+    if (!isStreamProtocol(mProtocol)) {
+        return reportError(dSocketOperation::READ_TCP, dSocketResult::WRONG_PROTOCOL, 0, tError);
+    }
+
+    //----------//
+
+    ssize_t ReadBytes;
+
+    if ((ReadBytes = recv(tSocket, tDstBuffer, tBufferSize, 0)) == -1) {
+        return reportError(dSocketOperation::READ_TCP, dSocketResult::READ_ERROR, errno, tError);
+    }
+
+    if (mCapture) {
+        mCapture -> record(dSocketOperation::READ_TCP, tSocket, ReadBytes);
+    }
+
+    *tReadBytes = ReadBytes;
+    return dSocketResult::SUCCESS;
+}
+dSocketResult dSocket::writeTCP(int tSocket, const uint8_t* tSrcBuffer, size_t tBufferSize, ssize_t* tWrittenBytes, dSocketError* tError) {
+    if (mType != dSocketType::SERVER) {
+        return reportError(dSocketOperation::WRITE_TCP, dSocketResult::WRONG_SOCKET_TYPE, 0, tError);
+    }
+
+    if (!isStreamProtocol(mProtocol)) {
+        return reportError(dSocketOperation::WRITE_TCP, dSocketResult::WRONG_PROTOCOL, 0, tError);
+    }
+
+    //----------//
+
+    ssize_t WrittenBytes;
+
+    if ((WrittenBytes = send(tSocket, tSrcBuffer, tBufferSize, MSG_NOSIGNAL)) == -1) {
+        return reportError(dSocketOperation::WRITE_TCP, dSocketResult::WRITE_ERROR, errno, tError);
+    }
+
+    if (mCapture) {
+        mCapture -> record(dSocketOperation::WRITE_TCP, tSocket, WrittenBytes);
+    }
+
+    *tWrittenBytes = WrittenBytes;
+    return dSocketResult::SUCCESS;
+}
+
+/**
+ * Function for reading data from the TCP socket along with the kernel receive timestamp
+ * (requires setTimestampingOption)
+ * @param tDstBuffer Buffer to put data into
+ * @param tBufferSize Buffer size
+ * @param tReadBytes Number of bytes actually received
+ * @param tTimestamp Receive timestamp (zero if not available)
+ * @param tError Failure details, filled only on failure (optional)
+ * @return Status
+ */
+dSocketResult dSocket::readTCP(uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes, dSocketTimestamp* tTimestamp, dSocketError* tError) {
+    if (mType != dSocketType::CLIENT) {
+        return reportError(dSocketOperation::READ_TCP, dSocketResult::WRONG_SOCKET_TYPE, 0, tError);
+    }
+
+    if (!isStreamProtocol(mProtocol)) {
+        return reportError(dSocketOperation::READ_TCP, dSocketResult::WRONG_PROTOCOL, 0, tError);
+    }
+
+    //----------//
+
+    return receiveTimestamped(dSocketOperation::READ_TCP, mSocket, tDstBuffer, tBufferSize, tReadBytes, nullptr, nullptr, tTimestamp, tError);
+}
+/**
+ * Function for reading data from the specified TCP client along with the kernel receive
+ * timestamp (requires the timestamping option on the accepted socket)
+ * @param tSocket Client socket
+ * @param tDstBuffer Buffer to put data into
+ * @param tBufferSize Buffer size
+ * @param tReadBytes Number of bytes actually received
+ * @param tTimestamp Receive timestamp (zero if not available)
+ * @param tError Failure details, filled only on failure (optional)
+ * @return Status
+ */
+dSocketResult dSocket::readTCP(int tSocket, uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes, dSocketTimestamp* tTimestamp, dSocketError* tError) {
+    if (mType != dSocketType::SERVER) {
+        return reportError(dSocketOperation::READ_TCP, dSocketResult::WRONG_SOCKET_TYPE, 0, tError);
+    }
+
+    if (!isStreamProtocol(mProtocol)) {
+        return reportError(dSocketOperation::READ_TCP, dSocketResult::WRONG_PROTOCOL, 0, tError);
+    }
+
+    //----------//
+
+    return receiveTimestamped(dSocketOperation::READ_TCP, tSocket, tDstBuffer, tBufferSize, tReadBytes, nullptr, nullptr, tTimestamp, tError);
+}
+
+/**
+ * Function for sending the messages queued by any number of threads to the server. Must be
+ * called by one thread at a time. Stops early if a non-blocking socket is full, in this case
+ * the queue is left non-empty
+ * @param tQueue Queue to drain
+ * @param tWrittenBytes Number of bytes actually written
+ * @param tError Failure details, filled only on failure (optional)
+ * @return Status
+ */
+dSocketResult dSocket::writeQueuedTCP(dSocketSendQueue* tQueue, ssize_t* tWrittenBytes, dSocketError* tError) {
+    if (mType != dSocketType::CLIENT) {
+        return reportError(dSocketOperation::WRITE_TCP, dSocketResult::WRONG_SOCKET_TYPE, 0, tError);
+    }
+
+    if (!isStreamProtocol(mProtocol)) {
+        return reportError(dSocketOperation::WRITE_TCP, dSocketResult::WRONG_PROTOCOL, 0, tError);
+    }
+
+    //----------//
+
+    return flushQueue(mSocket, tQueue, tWrittenBytes, tError);
+}
+/**
+ * Function for sending the messages queued by any number of threads to the specified
+ * client. Must be called by one thread at a time. Stops early if a non-blocking socket is
+ * full, in this case the queue is left non-empty
+ * @param tSocket Client socket
+ * @param tQueue Queue to drain
+ * @param tWrittenBytes Number of bytes actually written
+ * @param tError Failure details, filled only on failure (optional)
+ * @return Status
+ */
+dSocketResult dSocket::writeQueuedTCP(int tSocket, dSocketSendQueue* tQueue, ssize_t* tWrittenBytes, dSocketError* tError) {
+    if (mType != dSocketType::SERVER) {
+        return reportError(dSocketOperation::WRITE_TCP, dSocketResult::WRONG_SOCKET_TYPE, 0, tError);
+    }
+
+    if (!isStreamProtocol(mProtocol)) {
+        return reportError(dSocketOperation::WRITE_TCP, dSocketResult::WRONG_PROTOCOL, 0, tError);
+    }
+
+    //----------//
+
+    return flushQueue(tSocket, tQueue, tWrittenBytes, tError);
+}
+
+/**
+ * Function for reading data from the UDP server that this socket is connected to
+ * @param tDstBuffer Buffer to put data into
+ * @param tBufferSize Buffer size
+ * @param tReadBytes Number of bytes actually received
+ * @param tError Failure details, filled only on failure (optional)
+ * @return Status
+ */
+dSocketResult dSocket::readUDP(uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes, dSocketError* tError) {
+    if (mType != dSocketType::CLIENT) {
+        return reportError(dSocketOperation::READ_UDP, dSocketResult::WRONG_SOCKET_TYPE, 0, tError);
+    }
+
+    if (!isDatagramProtocol(mProtocol)) {
+        return reportError(dSocketOperation::READ_UDP, dSocketResult::WRONG_PROTOCOL, 0, tError);
+    }
+
+    //----------//
+
+    ssize_t ReadBytes;
+
+    if ((ReadBytes = recvfrom(mSocket, tDstBuffer, tBufferSize, 0, nullptr, nullptr)) == -1) {
+        return reportError(dSocketOperation::READ_UDP, dSocketResult::READ_ERROR, errno, tError);
+    }
+
+    if (mCapture) {
+        mCapture -> record(dSocketOperation::READ_UDP, mSocket, ReadBytes);
+    }
+
+    *tReadBytes = ReadBytes;
+    return dSocketResult::SUCCESS;
+}
+/**
+ * Function for writing data to the UDP server that this socket is connected to
+ * @param tSrcBuffer Buffer with the data to send
+ * @param tBufferSize Buffer size
+ * @param tWrittenBytes Number of bytes actually written
+ * @param tError Failure details, filled only on failure (optional)
+ * @return Status
+ */
+dSocketResult dSocket::writeUDP(const uint8_t* tSrcBuffer, size_t tBufferSize, ssize_t* tWrittenBytes, dSocketError* tError) {
+    if (mType != dSocketType::CLIENT) {
+        return reportError(dSocketOperation::WRITE_UDP, dSocketResult::WRONG_SOCKET_TYPE, 0, tError);
+    }
+
+    if (!isDatagramProtocol(mProtocol)) {
+        return reportError(dSocketOperation::WRITE_UDP, dSocketResult::WRONG_PROTOCOL, 0, tError);
+    }
+
+    //----------//
+
+    ssize_t WrittenBytes;
+
+    if ((WrittenBytes = sendto(mSocket, tSrcBuffer, tBufferSize, 0, mStructSize ? (const struct sockaddr*)&mStruct : nullptr, mStructSize)) == -1) {
+        return reportError(dSocketOperation::WRITE_UDP, dSocketResult::WRITE_ERROR, errno, tError);
+    }
+
+    if (mCapture) {
+        mCapture -> record(dSocketOperation::WRITE_UDP, mSocket, WrittenBytes);
+    }
+
+    *tWrittenBytes = WrittenBytes;
+    return dSocketResult::SUCCESS;
+}
+
+/**
+ * Function for reading data from the specified UDP client
+ * @param tDstBuffer Buffer to put data into
+ * @param tBufferSize Buffer size
+ * @param tReadBytes Number of bytes actually received
+ * @param tClientStruct Client data structure
+ * @param tClientStructSize Client data structure size
+ * @param tError Failure details, filled only on failure (optional)
+ * @return Status
+ */
+dSocketResult dSocket::readUDP(uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes, sockaddr* tClientStruct, socklen_t* tClientStructSize, dSocketError* tError) {
+    if (mType != dSocketType::SERVER) {
+        return reportError(dSocketOperation::READ_UDP, dSocketResult::WRONG_SOCKET_TYPE, 0, tError);
+    }
+
+    if (!isDatagramProtocol(mProtocol)) {
+        return reportError(dSocketOperation::READ_UDP, dSocketResult::WRONG_PROTOCOL, 0, tError);
+    }
+
+    //----------//
+
+    ssize_t ReadBytes;
+
+    if ((ReadBytes = recvfrom(mSocket, tDstBuffer, tBufferSize, 0, tClientStruct, tClientStructSize)) == -1) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return reportError(dSocketOperation::READ_UDP, dSocketResult::RECV_TIMEOUT, errno, tError);
+        }
+
+        return reportError(dSocketOperation::READ_UDP, dSocketResult::READ_ERROR, errno, tError);
+    }
+
+    if (mCapture) {
+        mCapture -> record(dSocketOperation::READ_UDP, mSocket, ReadBytes);
+    }
+
+    *tReadBytes = ReadBytes;
+    return dSocketResult::SUCCESS;
+}
+/**
+ * Function for writing data to the specified UDP client
+ * @param tSrcBuffer Buffer with the data to send
+ * @param tBufferSize Buffer size
+ * @param tWrittenBytes Number of bytes actually written
+ * @param tClientStruct Client data structure
+ * @param tClientStructSize Client data structure size
+ * @param tError Failure details, filled only on failure (optional)
+ * @return Status
+ */
+dSocketResult dSocket::writeUDP(const uint8_t* tSrcBuffer, size_t tBufferSize, ssize_t* tWrittenBytes, const sockaddr* tClientStruct, socklen_t tClientStructSize, dSocketError* tError) {
+    if (mType != dSocketType::SERVER) {
+        return reportError(dSocketOperation::WRITE_UDP, dSocketResult::WRONG_SOCKET_TYPE, 0, tError);
+    }
+
+    if (!isDatagramProtocol(mProtocol)) {
+        return reportError(dSocketOperation::WRITE_UDP, dSocketResult::WRONG_PROTOCOL, 0, tError);
+    }
+
+    //----------//
+
+    ssize_t WrittenBytes;
+
+    if ((WrittenBytes = sendto(mSocket, tSrcBuffer, tBufferSize, 0, tClientStruct, tClientStructSize)) == -1) {
+        return reportError(dSocketOperation::WRITE_UDP, dSocketResult::WRITE_ERROR, errno, tError);
+    }
+
+    if (mCapture) {
+        mCapture -> record(dSocketOperation::WRITE_UDP, mSocket, WrittenBytes);
+    }
+
+    *tWrittenBytes = WrittenBytes;
+    return dSocketResult::SUCCESS;
+}
+/**
+ * Function for reading data from the UDP server along with the kernel receive timestamp
+ * (requires setTimestampingOption)
+ * @param tDstBuffer Buffer to put data into
+ * @param tBufferSize Buffer size
+ * @param tReadBytes Number of bytes actually received
+ * @param tTimestamp Receive timestamp (zero if not available)
+ * @param tError Failure details, filled only on failure (optional)
+ * @return Status
+ */
+dSocketResult dSocket::readUDP(uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes, dSocketTimestamp* tTimestamp, dSocketError* tError) {
+    if (mType != dSocketType::CLIENT) {
+        return reportError(dSocketOperation::READ_UDP, dSocketResult::WRONG_SOCKET_TYPE, 0, tError);
+    }
+
+    if (!isDatagramProtocol(mProtocol)) {
+        return reportError(dSocketOperation::READ_UDP, dSocketResult::WRONG_PROTOCOL, 0, tError);
+    }
+
+    //----------//
+
+    return receiveTimestamped(dSocketOperation::READ_UDP, mSocket, tDstBuffer, tBufferSize, tReadBytes, nullptr, nullptr, tTimestamp, tError);
+}
+/**
+ * Function for reading data from the specified UDP client along with the kernel receive
+ * timestamp (requires setTimestampingOption)
+ * @param tDstBuffer Buffer to put data into
+ * @param tBufferSize Buffer size
+ * @param tReadBytes Number of bytes actually received
+ * @param tClientStruct Client data structure
+ * @param tClientStructSize Client data structure size
+ * @param tTimestamp Receive timestamp (zero if not available)
+ * @param tError Failure details, filled only on failure (optional)
+ * @return Status
+ */
+dSocketResult dSocket::readUDP(uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes, sockaddr* tClientStruct, socklen_t* tClientStructSize, dSocketTimestamp* tTimestamp, dSocketError* tError) {
+    if (mType != dSocketType::SERVER) {
+        return reportError(dSocketOperation::READ_UDP, dSocketResult::WRONG_SOCKET_TYPE, 0, tError);
+    }
+
+    if (!isDatagramProtocol(mProtocol)) {
+        return reportError(dSocketOperation::READ_UDP, dSocketResult::WRONG_PROTOCOL, 0, tError);
+    }
+
+    //----------//
+
+    return receiveTimestamped(dSocketOperation::READ_UDP, mSocket, tDstBuffer, tBufferSize, tReadBytes, tClientStruct, tClientStructSize, tTimestamp, tError);
+}
+
+/**
+ * Function for sending the same datagram to a list of peers with as few sendmmsg calls as
+ * possible. A peer the kernel rejects (unreachable, refused, not permitted) is skipped, the
+ * rest still get it. A full send buffer stops the batch: the call returns WOULD_BLOCK and
+ * can be repeated for the peers from index *tSentCount + number of skipped peers on
+ * @param tSrcBuffer Buffer with the data to send
+ * @param tBufferSize Buffer size
+ * @param tPeers Peer addresses
+ * @param tPeerCount Number of peers
+ * @param tSentCount Number of peers the datagram was actually sent to
+ * @param tFailedPeers Indices of the skipped peers (optional)
+ * @param tError Details of the last failure, filled only on failure (optional)
+ * @return Status (WOULD_BLOCK if the send buffer was full, WRITE_ERROR if at least one peer
+ * was skipped or the socket itself failed)
+ */
+dSocketResult dSocket::fanOutUDP(const uint8_t* tSrcBuffer, size_t tBufferSize, const sockaddr_in* tPeers, size_t tPeerCount, size_t* tSentCount,
+                                 std::vector <size_t>* tFailedPeers, dSocketError* tError) {
+    *tSentCount = 0;
+
+    if (mProtocol != dSocketProtocol::UDP) {
+        return reportError(dSocketOperation::WRITE_UDP, dSocketResult::WRONG_PROTOCOL, 0, tError);
+    }
+
+    //----------//
+
+    constexpr size_t BatchSize = 256;
+
+    //---All messages share the single read-only payload vector---//
+
+    iovec Payload {
+            .iov_base = const_cast <uint8_t*>(tSrcBuffer),
+            .iov_len = tBufferSize
+    };
+    mmsghdr Messages[BatchSize];
+    size_t Position = 0;
+    size_t Sent = 0;
+    dSocketResult Status = dSocketResult::SUCCESS;
+
+    while (Position < tPeerCount) {
+        size_t Count = std::min(BatchSize, tPeerCount - Position);
+
+        for (size_t i = 0; i < Count; i++) {
+            Messages[i] = {};
+
+            Messages[i].msg_hdr.msg_name        = const_cast <sockaddr_in*>(&tPeers[Position + i]);
+            Messages[i].msg_hdr.msg_namelen     = sizeof(sockaddr_in);
+            Messages[i].msg_hdr.msg_iov         = &Payload;
+            Messages[i].msg_hdr.msg_iovlen      = 1;
+        }
+
+        int Result;
+
+        //---sendmmsg stops at a rejected peer and fails on the next call, which starts with it---//
+
+        if ((Result = sendmmsg(mSocket, Messages, Count, 0)) == -1) {
+            int Errno = errno;
+
+            if (Errno == EINTR) {
+                continue;
+            }
+
+            //---Transient, the peer is fine: stop and let the caller retry from here---//
+
+            if (Errno == EAGAIN || Errno == EWOULDBLOCK || Errno == ENOBUFS) {
+                *tSentCount = Sent;
+                return reportError(dSocketOperation::WRITE_UDP, dSocketResult::WOULD_BLOCK, Errno, tError);
+            }
+
+            //---Anything not tied to this one peer would fail every other peer as well---//
+
+            if (Errno != EACCES && Errno != EPERM && Errno != EHOSTUNREACH && Errno != ENETUNREACH &&
+                Errno != ECONNREFUSED && Errno != EADDRNOTAVAIL && Errno != EAFNOSUPPORT) {
+                *tSentCount = Sent;
+                return reportError(dSocketOperation::WRITE_UDP, dSocketResult::WRITE_ERROR, Errno, tError);
+            }
+
+            Status = reportError(dSocketOperation::WRITE_UDP, dSocketResult::WRITE_ERROR, Errno, tError);
+
+            if (tFailedPeers) {
+                tFailedPeers -> push_back(Position);
+            }
+
+            Position++;
+            continue;
+        }
+
+        if (mCapture) {
+            for (int i = 0; i < Result; i++) {
+                mCapture -> record(dSocketOperation::WRITE_UDP, mSocket, static_cast <ssize_t>(Messages[i].msg_len));
+            }
+        }
+
+        Position += Result;
+        Sent += Result;
+    }
+
+    *tSentCount = Sent;
+    return Status;
+}
+//-----------------------------//
+/**
+ * Function for closing the owned socket
+ */
+void dSocket::closeSocket() {
+    if (mSocket >= 0) {
+        shutdown(mSocket, SHUT_RDWR);
+        close(mSocket);
+    }
+
+    //---Unix server removes the file it created---//
+
+    if (mOwnsPath) {
+        unlink(reinterpret_cast <sockaddr_un*>(&mStruct) -> sun_path);
+    }
+
+    mSocket     = -1;
+    mOwnsPath   = false;
+}
+/**
+ * Function for removing the file at a Unix socket path before binding to it. Only a socket
+ * file no live socket is bound to is removed. Bound sockets are looked up in /proc/net/unix,
+ * which does not disturb the owner; only if it cannot be read the path is probed with
+ * connect (refused means stale), and a live owner then accepts one empty connection
+ * @param tStruct Address with a non-abstract path
+ * @return errno value, 0 if the path is free now (EADDRINUSE if it is in use or not a socket)
+ */
+int dSocket::removeStalePath(const sockaddr_un* tStruct) const {
+    struct stat Status = {};
+
+    if (lstat(tStruct -> sun_path, &Status) == -1) {
+        return errno == ENOENT ? 0 : errno;
+    }
+
+    if (!S_ISSOCK(Status.st_mode)) {
+        return EADDRINUSE;
+    }
+
+    bool Bound;
+
+    if (findBoundPath(tStruct -> sun_path, Status, &Bound)) {
+        if (Bound) {
+            return EADDRINUSE;
+        }
+
+        if (unlink(tStruct -> sun_path) == -1 && errno != ENOENT) {
+            return errno;
+        }
+
+        return 0;
+    }
+
+    //---Fallback probe with the same socket type, a live server of the other type is still "in use"---//
+
+    int Probe;
+
+    if ((Probe = socket(AF_UNIX, (mProtocol == dSocketProtocol::UNIX_STREAM ? SOCK_STREAM : SOCK_DGRAM) | SOCK_CLOEXEC, 0)) == -1) {
+        return errno;
+    }
+
+    int Errno = 0;
+
+    if (connect(Probe, (const struct sockaddr*)tStruct, sizeof(sockaddr_un)) == -1) {
+        Errno = errno;
+    }
+
+    close(Probe);
+
+    if (Errno != ECONNREFUSED) {
+        return EADDRINUSE;
+    }
+
+    if (unlink(tStruct -> sun_path) == -1 && errno != ENOENT) {
+        return errno;
+    }
+
+    return 0;
+}
+/**
+ * Function checks whether a socket is bound to the given file, using /proc/net/unix. Listed
+ * absolute paths are compared by inode (so the same file reached by another path counts),
+ * relative ones by name
+ * @param tPath Socket file path
+ * @param tStatus lstat result for the path
+ * @param tBound Whether a bound socket was found
+ * @return false if the table could not be read
+ */
+bool dSocket::findBoundPath(const char* tPath, const struct stat& tStatus, bool* tBound) {
+    std::ifstream Table("/proc/net/unix");
+
+    if (!Table) {
+        return false;
+    }
+
+    std::string Line;
+    std::getline(Table, Line);          //---Header---//
+
+    *tBound = false;
+
+    while (std::getline(Table, Line)) {
+        int PathOffset = -1;
+
+        //---Num RefCount Protocol Flags Type St Inode Path (the path may be missing)---//
+
+        sscanf(Line.c_str(), "%*s %*s %*s %*s %*s %*s %*s %n", &PathOffset);
+
+        if (PathOffset < 0 || static_cast <size_t>(PathOffset) >= Line.size() || Line[PathOffset] == '@') {
+            continue;
+        }
+
+        std::string Path = Line.substr(PathOffset);
+        struct stat Listed = {};
+
+        if (Path == tPath ||
+            (Path[0] == '/' && lstat(Path.c_str(), &Listed) == 0 && Listed.st_dev == tStatus.st_dev && Listed.st_ino == tStatus.st_ino)) {
+            *tBound = true;
+            return true;
+        }
+    }
+
+    return true;
+}
+/**
+ * Function for adding or dropping a multicast group membership
+ * @param tOption IP_ADD_MEMBERSHIP or IP_DROP_MEMBERSHIP
+ * @param tGroupAddress Multicast group address
+ * @param tInterfaceAddress Local interface address (any interface if empty)
+ * @return Status
+ */
+dSocketResult dSocket::changeMembership(int tOption, const std::string& tGroupAddress, const std::string& tInterfaceAddress) {
+    if (mProtocol != dSocketProtocol::UDP) {
+        return reportError(dSocketOperation::SET_OPTION, dSocketResult::WRONG_PROTOCOL);
+    }
+
+    //----------//
+
+    ip_mreq Request = {};
+
+    if (inet_pton(AF_INET, tGroupAddress.data(), &Request.imr_multiaddr) <= 0) {
+        return reportError(dSocketOperation::SET_OPTION, dSocketResult::ADDRESS_CONVERSION_FAILURE, errno);
+    }
+
+    if (tInterfaceAddress.empty()) {
+        Request.imr_interface.s_addr = htonl(INADDR_ANY);
+    } else if (inet_pton(AF_INET, tInterfaceAddress.data(), &Request.imr_interface) <= 0) {
+        return reportError(dSocketOperation::SET_OPTION, dSocketResult::ADDRESS_CONVERSION_FAILURE, errno);
+    }
+
+    if (setsockopt(mSocket, IPPROTO_IP, tOption, &Request, sizeof(Request)) == -1) {
+        return reportError(dSocketOperation::SET_OPTION, dSocketResult::SET_OPTION_FAILURE, errno);
+    }
+
+    return dSocketResult::SUCCESS;
+}
+/**
+ * Function for setting SO_TIMESTAMPING. The kernel refuses timestamp ids on TCP sockets that
+ * are not connected, so for this socket the option is deferred until connectToServer (client)
+ * or applied to every accepted socket (server)
+ * @param tSocket Socket (this socket or an accepted one)
+ * @param tEnable Flag
+ * @return errno value, 0 on success
+ */
+int dSocket::setTimestamping(int tSocket, bool tEnable) {
+    int Flags = tEnable ? TimestampingFlags : 0;
+
+    if (setsockopt(tSocket, SOL_SOCKET, SO_TIMESTAMPING, &Flags, sizeof(Flags)) == -1) {
+        if (errno == EINVAL && tSocket == mSocket && mProtocol == dSocketProtocol::TCP) {
+            mTimestampingPending = tEnable;
+            return 0;
+        }
+
+        return errno;
+    }
+
+    //---Stream servers keep the request for the sockets they accept---//
+
+    if (tSocket == mSocket) {
+        mTimestampingPending = tEnable && isStreamProtocol(mProtocol) && mType != dSocketType::CLIENT;
+    }
+
+    return 0;
+}
+/**
+ * Function for applying the option profile and a pending SO_TIMESTAMPING request to an
+ * accepted socket and marking the start of the connection in the capture. Failures are
+ * recorded as the last error but do not fail the accept
+ * @param tSocket Accepted socket
+ */
+void dSocket::prepareAcceptedSocket(int tSocket) {
+    if (mCapture) {
+        mCapture -> record(dSocketOperation::ACCEPT, tSocket, 0);
+    }
 
-            FD_ZERO(&WaitSet);
-            FD_SET(mSocket, &WaitSet);
+    applyOptionProfile(tSocket);
 
-            Result = select(mSocket + 1, nullptr, &WaitSet, nullptr, &Timeout);
-        }
-    } else {
-        Result = 1;
-    }
+    if (mTimestampingPending) {
+        int Errno = setTimestamping(tSocket, true);
 
-    if (fcntl(mSocket, F_SETFL, Flags) < 0) {
-        if (mVerbose) {
-            mLastErrno = errno;
-            std::cerr << "dSocket::connectToServer" << std::endl;
+        if (Errno) {
+            reportError(dSocketOperation::ACCEPT, dSocketResult::SET_OPTION_FAILURE, Errno);
         }
-
-        return dSocketResult::SET_FLAGS_FAILURE;
     }
+}
+/**
+ * Function for receiving data with recvmsg and extracting the SCM_TIMESTAMPING control
+ * message
+ * @param tOperation Operation to report failures as
+ * @param tSocket Socket to read from
+ * @param tDstBuffer Buffer to put data into
+ * @param tBufferSize Buffer size
+ * @param tReadBytes Number of bytes actually received
+ * @param tStruct Sender address structure (may be nullptr)
+ * @param tStructSize Sender address structure size (may be nullptr)
+ * @param tTimestamp Receive timestamp (zero if not available)
+ * @param tError Failure details, filled only on failure (optional)
+ * @return Status
+ */
+dSocketResult dSocket::receiveTimestamped(dSocketOperation tOperation, int tSocket, uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes,
+                                          sockaddr* tStruct, socklen_t* tStructSize, dSocketTimestamp* tTimestamp, dSocketError* tError) {
+    alignas(cmsghdr) uint8_t Control[256];
+    iovec Vector {
+            .iov_base = tDstBuffer,
+            .iov_len = tBufferSize
+    };
+    msghdr Message = {};
+    ssize_t ReadBytes;
 
-    if (Result < 0) {
-        if (mVerbose) {
-            mLastErrno = errno;
-            std::cerr << "dSocket::connectToServer" << std::endl;
-        }
+    Message.msg_name        = tStruct;
+    Message.msg_namelen     = tStructSize ? *tStructSize : 0;
+    Message.msg_iov         = &Vector;
+    Message.msg_iovlen      = 1;
+    Message.msg_control     = Control;
+    Message.msg_controllen  = sizeof(Control);
 
-        return dSocketResult::CONNECTION_FAILURE;
-    } else if (Result == 0) {
-        errno = ETIMEDOUT;
-        if (mVerbose) {
-            mLastErrno = errno;
-            std::cerr << "dSocket::connectToServer" << std::endl;
+    if ((ReadBytes = recvmsg(tSocket, &Message, 0)) == -1) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return reportError(tOperation, dSocketResult::RECV_TIMEOUT, errno, tError);
         }
 
-        return dSocketResult::CONNECTION_TIMEOUT;
-    } else {
-        socklen_t Length = sizeof(Flags);
+        return reportError(tOperation, dSocketResult::READ_ERROR, errno, tError);
+    }
 
-        if (getsockopt(mSocket, SOL_SOCKET, SO_ERROR, &Flags, &Length) < 0) {
-            if (mVerbose) {
-                mLastErrno = errno;
-                std::cerr << "dSocket::connectToServer" << std::endl;
-            }
+    if (tStructSize) {
+        *tStructSize = Message.msg_namelen;
+    }
 
-            return dSocketResult::GET_OPTION_FAILURE;
-        }
+    *tTimestamp = {};
 
-        if (Flags) {
-            if (mVerbose) {
-                std::cerr << "dSocket::connectToServer" << std::endl;
-            }
+    for (cmsghdr* Header = CMSG_FIRSTHDR(&Message); Header; Header = CMSG_NXTHDR(&Message, Header)) {
+        if (Header -> cmsg_level == SOL_SOCKET && Header -> cmsg_type == SCM_TIMESTAMPING) {
+            auto* Stamps = reinterpret_cast <scm_timestamping*>(CMSG_DATA(Header));
 
-            switch (Flags) {
-                case 111:
-                    mLastErrno = errno;
-                    return dSocketResult::CONNECTION_REFUSED;
-                case 113:
-                    mLastErrno = errno;
-                    return dSocketResult::HOST_UNREACHABLE;
-                default:
-                    std::cerr << "Unknown (SO_ERROR " << Flags << ")" << std::endl;
-                    return dSocketResult::UNKNOWN;
-            }
+            tTimestamp -> Software = static_cast <uint64_t>(Stamps -> ts[0].tv_sec) * 1000000000 + Stamps -> ts[0].tv_nsec;
         }
     }
-#elif _WIN32
-    if (connect(mClientSocket, (struct sockaddr*)&mClientStruct, sizeof(mClientStruct)) < 0) {
-        throw dSocketException(dSocketException::CONNECT_ERROR, strerror(errno));
-    }
 
-    ///---DO SOMETHING---///
-#endif
+    if (mCapture) {
+        mCapture -> record(tOperation, tSocket, ReadBytes);
+    }
 
+    *tReadBytes = ReadBytes;
     return dSocketResult::SUCCESS;
 }
-//-----------------------------//
 /**
- * Function for reading data from the TCP socket
+ * Function for receiving data and SCM_RIGHTS descriptors with recvmsg. Descriptors that do
+ * not fit into the array are closed
+ * @param tSocket Socket to read from
  * @param tDstBuffer Buffer to put data into
  * @param tBufferSize Buffer size
  * @param tReadBytes Number of bytes actually received
+ * @param tDescriptors Array to put descriptors into
+ * @param tDescriptorCount Array capacity on input, number of received descriptors on output
+ * @param tError Failure details, filled only on failure (optional)
  * @return Status
  */
-dSocketResult dSocket::readTCP(uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes) {
-    if (mType != dSocketType::CLIENT) {
-        if (mVerbose) {
-            std::cerr << "dSocket::readUDP" << std::endl;
-        }
+dSocketResult dSocket::receiveDescriptors(int tSocket, uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes, int* tDescriptors, size_t* tDescriptorCount, dSocketError* tError) {
+    alignas(cmsghdr) uint8_t Control[CMSG_SPACE(sizeof(int) * DescriptorLimit)];
+    iovec Vector {
+            .iov_base = tDstBuffer,
+            .iov_len = tBufferSize
+    };
+    msghdr Message = {};
+    ssize_t ReadBytes;
 
-        return dSocketResult::WRONG_SOCKET_TYPE;
-    }
+    Message.msg_iov         = &Vector;
+    Message.msg_iovlen      = 1;
+    Message.msg_control     = Control;
+    Message.msg_controllen  = sizeof(Control);
 
+    if ((ReadBytes = recvmsg(tSocket, &Message, MSG_CMSG_CLOEXEC)) == -1) {
+        *tDescriptorCount = 0;
 
-    if (mProtocol != dSocketProtocol::TCP) {
-        if (mVerbose) {
-            std::cerr << "dSocket::readTCP" << std::endl;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return reportError(dSocketOperation::READ_DESCRIPTORS, dSocketResult::RECV_TIMEOUT, errno, tError);
         }
 
-        return dSocketResult::WRONG_PROTOCOL;
+        return reportError(dSocketOperation::READ_DESCRIPTORS, dSocketResult::READ_ERROR, errno, tError);
     }
 
-    //----------//
-
-    ssize_t ReadBytes;
+    size_t Capacity = *tDescriptorCount;
+    size_t Count = 0;
 
-    if ((ReadBytes = recv(mSocket, tDstBuffer, tBufferSize, 0)) == -1) {
-        if (mVerbose) {
-            mLastErrno = errno;
-            std::cerr << "dSocket::readTCP" << std::endl;
+    for (cmsghdr* Header = CMSG_FIRSTHDR(&Message); Header; Header = CMSG_NXTHDR(&Message, Header)) {
+        if (Header -> cmsg_level != SOL_SOCKET || Header -> cmsg_type != SCM_RIGHTS) {
+            continue;
         }
 
-        return dSocketResult::READ_ERROR;
+        size_t Received = (Header -> cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        auto* Data = CMSG_DATA(Header);
+
+        for (size_t i = 0; i < Received; i++) {
+            int Descriptor;
+            std::memcpy(&Descriptor, Data + i * sizeof(int), sizeof(int));
+
+            if (Count < Capacity) {
+                tDescriptors[Count++] = Descriptor;
+            } else {
+                close(Descriptor);
+            }
+        }
     }
 
+    *tDescriptorCount = Count;
     *tReadBytes = ReadBytes;
     return dSocketResult::SUCCESS;
 }
 /**
- * Function for writing data to the TCP socket
+ * Function for sending data and SCM_RIGHTS descriptors with sendmsg
+ * @param tSocket Socket to write to
  * @param tSrcBuffer Buffer with the data to send
  * @param tBufferSize Buffer size
+ * @param tDescriptors Descriptors to pass
+ * @param tDescriptorCount Number of descriptors (up to DescriptorLimit)
  * @param tWrittenBytes Number of bytes actually written
+ * @param tError Failure details, filled only on failure (optional)
  * @return Status
  */
-dSocketResult dSocket::writeTCP(const uint8_t* tSrcBuffer, size_t tBufferSize, ssize_t* tWrittenBytes) {
-    if (mType != dSocketType::CLIENT) {
-        if (mVerbose) {
-            std::cerr << "dSocket::readUDP" << std::endl;
-        }
-
-        return dSocketResult::WRONG_SOCKET_TYPE;
+dSocketResult dSocket::sendDescriptors(int tSocket, const uint8_t* tSrcBuffer, size_t tBufferSize, const int* tDescriptors, size_t tDescriptorCount, ssize_t* tWrittenBytes, dSocketError* tError) {
+    if (tDescriptorCount > DescriptorLimit) {
+        return reportError(dSocketOperation::WRITE_DESCRIPTORS, dSocketResult::WRITE_ERROR, EINVAL, tError);
     }
 
+    //----------//
 
-    if (mProtocol != dSocketProtocol::TCP) {
-        if (mVerbose) {
-            std::cerr << "dSocket::writeTCP" << std::endl;
-        }
+    alignas(cmsghdr) uint8_t Control[CMSG_SPACE(sizeof(int) * DescriptorLimit)];
+    iovec Vector {
+            .iov_base = const_cast <uint8_t*>(tSrcBuffer),
+            .iov_len = tBufferSize
+    };
+    msghdr Message = {};
+    ssize_t WrittenBytes;
 
-        return dSocketResult::WRONG_PROTOCOL;
-    }
+    Message.msg_iov         = &Vector;
+    Message.msg_iovlen      = 1;
 
-    //----------//
+    if (tDescriptorCount > 0) {
+        Message.msg_control     = Control;
+        Message.msg_controllen  = CMSG_SPACE(sizeof(int) * tDescriptorCount);
 
-    ssize_t WrittenBytes;
+        cmsghdr* Header = CMSG_FIRSTHDR(&Message);
 
-    if ((WrittenBytes = send(mSocket, tSrcBuffer, tBufferSize, MSG_NOSIGNAL)) == -1) {
-        if (mVerbose) {
-            mLastErrno = errno;
-            std::cerr << "dSocket::writeTCP" << std::endl;
-        }
+        Header -> cmsg_level    = SOL_SOCKET;
+        Header -> cmsg_type     = SCM_RIGHTS;
+        Header -> cmsg_len      = CMSG_LEN(sizeof(int) * tDescriptorCount);
+
+        std::memcpy(CMSG_DATA(Header), tDescriptors, sizeof(int) * tDescriptorCount);
+    }
 
-        return dSocketResult::WRITE_ERROR;
+    if ((WrittenBytes = sendmsg(tSocket, &Message, MSG_NOSIGNAL)) == -1) {
+        return reportError(dSocketOperation::WRITE_DESCRIPTORS, dSocketResult::WRITE_ERROR, errno, tError);
     }
 
     *tWrittenBytes = WrittenBytes;
     return dSocketResult::SUCCESS;
 }
+/**
+ * Function for draining a send queue with batched sendmsg calls
+ * @param tSocket Socket to write to
+ * @param tQueue Queue to drain
+ * @param tWrittenBytes Number of bytes actually written
+ * @param tError Failure details, filled only on failure (optional)
+ * @return Status
+ */
+dSocketResult dSocket::flushQueue(int tSocket, dSocketSendQueue* tQueue, ssize_t* tWrittenBytes, dSocketError* tError) {
+    constexpr int BatchSize = 64;
 
+    iovec Vector[BatchSize];
+    msghdr Message = {};
+    ssize_t TotalBytes = 0;
+    ssize_t WrittenBytes;
+    int Count;
 
+    while ((Count = tQueue -> collect(Vector, BatchSize)) > 0) {
+        Message.msg_iov     = Vector;
+        Message.msg_iovlen  = Count;
 
-dSocketResult dSocket::readTCP(int tSocket, uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes) {
-    if (mType != dSocketType::SERVER) {
-        if (mVerbose) {
-            std::cerr << "dSocket::readUDP" << std::endl;
-        }
-
-        return dSocketResult::WRONG_SOCKET_TYPE;
-    }
-
-    if (mProtocol != dSocketProtocol::TCP) {
-        return dSocketResult::WRONG_PROTOCOL;
-    }
+        if ((WrittenBytes = sendmsg(tSocket, &Message, MSG_NOSIGNAL)) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
 
-    //----------//
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
 
-    ssize_t ReadBytes;
+            *tWrittenBytes = TotalBytes;
+            return reportError(dSocketOperation::WRITE_TCP, dSocketResult::WRITE_ERROR, errno, tError);
+        }
 
-    if ((ReadBytes = recv(tSocket, tDstBuffer, tBufferSize, 0)) == -1) {
-        if (mVerbose) {
-            mLastErrno = errno;
-            std::cerr << "dSocket::readTCP" << std::endl;
+        if (mCapture) {
+            mCapture -> record(dSocketOperation::WRITE_TCP, tSocket, WrittenBytes);
         }
 
-        return dSocketResult::READ_ERROR;
+        tQueue -> consume(WrittenBytes);
+        TotalBytes += WrittenBytes;
     }
 
-    *tReadBytes = ReadBytes;
+    *tWrittenBytes = TotalBytes;
     return dSocketResult::SUCCESS;
 }
-dSocketResult dSocket::writeTCP(int tSocket, const uint8_t* tSrcBuffer, size_t tBufferSize, ssize_t* tWrittenBytes) {
-    if (mType != dSocketType::SERVER) {
-        if (mVerbose) {
-            std::cerr << "dSocket::readUDP" << std::endl;
-        }
+/**
+ * Function for recording a failure. The failure is handed to the caller, always stored as
+ * the latest one and, in verbose mode, pushed to the log sink without blocking
+ * @param tOperation Failed operation
+ * @param tResult Status to return
+ * @param tErrno Raw errno value (0 if not applicable)
+ * @param tError Caller's failure record to fill (may be nullptr)
+ * @return tResult
+ */
+dSocketResult dSocket::reportError(dSocketOperation tOperation, dSocketResult tResult, int tErrno, dSocketError* tError) {
+    dSocketError Error {
+            .Result = tResult,
+            .Operation = tOperation,
+            .Errno = tErrno
+    };
 
-        return dSocketResult::WRONG_SOCKET_TYPE;
+    if (tError) {
+        *tError = Error;
     }
 
-    if (mProtocol != dSocketProtocol::TCP) {
-        if (mVerbose) {
-            std::cerr << "dSocket::writeTCP" << std::endl;
-        }
+    mLastError.store(Error.pack(), std::memory_order_relaxed);
 
-        return dSocketResult::WRONG_PROTOCOL;
+    if (mLogSink) {
+        mLogSink -> push(Error, mSocket);
+    } else if (mVerbose) {
+        dSocketLogSink::startDefaultFlusher();
+        dSocketLogSink::instance().push(Error, mSocket);
     }
 
-    //----------//
-
-    ssize_t WrittenBytes;
+    return tResult;
+}
+/**
+ * Function checks whether the protocol is connection-oriented (read / write with *TCP)
+ * @param tProtocol Protocol
+ * @return true for TCP and Unix stream sockets
+ */
+bool dSocket::isStreamProtocol(dSocketProtocol tProtocol) {
+    return tProtocol == dSocketProtocol::TCP || tProtocol == dSocketProtocol::UNIX_STREAM;
+}
+/**
+ * Function checks whether the protocol is datagram-oriented (read / write with *UDP)
+ * @param tProtocol Protocol
+ * @return true for UDP and Unix datagram sockets
+ */
+bool dSocket::isDatagramProtocol(dSocketProtocol tProtocol) {
+    return tProtocol == dSocketProtocol::UDP || tProtocol == dSocketProtocol::UNIX_DGRAM;
+}
+/**
+ * Function for waiting until the listening socket has a pending connection
+ * @param tTimeoutMs Poll timeout value (-1 to wait indefinitely)
+ * @return Status
+ */
+dSocketResult dSocket::waitForConnection(int tTimeoutMs) {
+    pollfd Descriptor {
+            .fd = mSocket,
+            .events = POLLIN,
+            .revents = 0
+    };
+    int Result;
 
-    if ((WrittenBytes = send(tSocket, tSrcBuffer, tBufferSize, MSG_NOSIGNAL)) == -1) {
-        if (mVerbose) {
-            mLastErrno = errno;
-            std::cerr << "dSocket::writeTCP" << std::endl;
-        }
+    while ((Result = poll(&Descriptor, 1, tTimeoutMs)) == -1 && errno == EINTR) {}
 
-        return dSocketResult::WRITE_ERROR;
+    if (Result < 0) {
+        return reportError(dSocketOperation::ACCEPT, dSocketResult::ACCEPT_FAILURE, errno);
+    } else if (Result == 0) {
+        return dSocketResult::ACCEPT_TIMEOUT;
     }
 
-    *tWrittenBytes = WrittenBytes;
     return dSocketResult::SUCCESS;
 }
-
+//-----------------------------//
 /**
- * Function for reading data from the UDP server that this socket is connected to
+ * Function for reading data along with file descriptors passed by the peer (SCM_RIGHTS) from
+ * this Unix socket. Received descriptors are close-on-exec and owned by the caller
  * @param tDstBuffer Buffer to put data into
  * @param tBufferSize Buffer size
  * @param tReadBytes Number of bytes actually received
+ * @param tDescriptors Array to put descriptors into
+ * @param tDescriptorCount Array capacity on input, number of received descriptors on output
+ * @param tError Failure details, filled only on failure (optional)
  * @return Status
  */
-dSocketResult dSocket::readUDP(uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes) {
-    if (mType != dSocketType::CLIENT) {
-        if (mVerbose) {
-            std::cerr << "dSocket::readUDP" << std::endl;
-        }
-
-        return dSocketResult::WRONG_SOCKET_TYPE;
-    }
-
-    if (mProtocol != dSocketProtocol::UDP) {
-        if (mVerbose) {
-            std::cerr << "dSocket::readUDP" << std::endl;
-        }
-
-        return dSocketResult::WRONG_PROTOCOL;
+dSocketResult dSocket::readDescriptors(uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes, int* tDescriptors, size_t* tDescriptorCount, dSocketError* tError) {
+    if (mProtocol != dSocketProtocol::UNIX_STREAM && mProtocol != dSocketProtocol::UNIX_DGRAM) {
+        return reportError(dSocketOperation::READ_DESCRIPTORS, dSocketResult::WRONG_PROTOCOL, 0, tError);
     }
 
     //----------//
 
-    ssize_t ReadBytes;
-    socklen_t StructSize = sizeof(mStruct);
-
-    if ((ReadBytes = recvfrom(mSocket, tDstBuffer, tBufferSize, 0, (struct sockaddr*)&mStruct, &StructSize)) == -1) {
-        if (mVerbose) {
-            mLastErrno = errno;
-            std::cerr << "dSocket::readUDP" << std::endl;
-        }
-
-        return dSocketResult::READ_ERROR;
-    }
-
-    *tReadBytes = ReadBytes;
-    return dSocketResult::SUCCESS;
+    return receiveDescriptors(mSocket, tDstBuffer, tBufferSize, tReadBytes, tDescriptors, tDescriptorCount, tError);
 }
 /**
- * Function for writing data to the UDP server that this socket is connected to
+ * Function for writing data along with file descriptors (SCM_RIGHTS) to this Unix socket.
+ * At least one byte of data has to be sent with the descriptors
  * @param tSrcBuffer Buffer with the data to send
  * @param tBufferSize Buffer size
+ * @param tDescriptors Descriptors to pass
+ * @param tDescriptorCount Number of descriptors
  * @param tWrittenBytes Number of bytes actually written
+ * @param tError Failure details, filled only on failure (optional)
  * @return Status
  */
-dSocketResult dSocket::writeUDP(const uint8_t* tSrcBuffer, size_t tBufferSize, ssize_t* tWrittenBytes) {
-    if (mType != dSocketType::CLIENT) {
-        if (mVerbose) {
-            std::cerr << "dSocket::writeTCP" << std::endl;
-        }
-
-        return dSocketResult::WRONG_SOCKET_TYPE;
-    }
-
-    if (mProtocol != dSocketProtocol::UDP) {
-        if (mVerbose) {
-            std::cerr << "dSocket::writeUDP" << std::endl;
-        }
-
-        return dSocketResult::WRONG_PROTOCOL;
+dSocketResult dSocket::writeDescriptors(const uint8_t* tSrcBuffer, size_t tBufferSize, const int* tDescriptors, size_t tDescriptorCount, ssize_t* tWrittenBytes, dSocketError* tError) {
+    if (mProtocol != dSocketProtocol::UNIX_STREAM && mProtocol != dSocketProtocol::UNIX_DGRAM) {
+        return reportError(dSocketOperation::WRITE_DESCRIPTORS, dSocketResult::WRONG_PROTOCOL, 0, tError);
     }
 
     //----------//
 
-    ssize_t WrittenBytes;
-
-    if ((WrittenBytes = sendto(mSocket, tSrcBuffer, tBufferSize, 0, (const struct sockaddr*)&mStruct, sizeof(mStruct))) == -1) {
-        if (mVerbose) {
-            mLastErrno = errno;
-            std::cerr << "dSocket::writeUDP" << std::endl;
-        }
-
-        return dSocketResult::WRITE_ERROR;
-    }
-
-    *tWrittenBytes = WrittenBytes;
-    return dSocketResult::SUCCESS;
+    return sendDescriptors(mSocket, tSrcBuffer, tBufferSize, tDescriptors, tDescriptorCount, tWrittenBytes, tError);
 }
 
 /**
- * Function for reading data from the specified UDP client
+ * Function for reading data along with file descriptors passed by the specified client
+ * (SCM_RIGHTS). Received descriptors are close-on-exec and owned by the caller
+ * @param tSocket Client socket
  * @param tDstBuffer Buffer to put data into
  * @param tBufferSize Buffer size
  * @param tReadBytes Number of bytes actually received
- * @param tClientStruct Client data structure
- * @param tClientStructSize Client data structure size
+ * @param tDescriptors Array to put descriptors into
+ * @param tDescriptorCount Array capacity on input, number of received descriptors on output
+ * @param tError Failure details, filled only on failure (optional)
  * @return Status
  */
-dSocketResult dSocket::readUDP(uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes, sockaddr* tClientStruct, socklen_t* tClientStructSize) {
+dSocketResult dSocket::readDescriptors(int tSocket, uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes, int* tDescriptors, size_t* tDescriptorCount, dSocketError* tError) {
     if (mType != dSocketType::SERVER) {
-        if (mVerbose) {
-            std::cerr << "dSocket::readUDP" << std::endl;
-        }
+        return reportError(dSocketOperation::READ_DESCRIPTORS, dSocketResult::WRONG_SOCKET_TYPE, 0, tError);
+    }
 
-        return dSocketResult::WRONG_SOCKET_TYPE;
+    if (mProtocol != dSocketProtocol::UNIX_STREAM) {
+        return reportError(dSocketOperation::READ_DESCRIPTORS, dSocketResult::WRONG_PROTOCOL, 0, tError);
     }
 
-    if (mProtocol != dSocketProtocol::UDP) {
-        if (mVerbose) {
-            std::cerr << "dSocket::readUDP" << std::endl;
-        }
+    //----------//
 
-        return dSocketResult::WRONG_PROTOCOL;
+    return receiveDescriptors(tSocket, tDstBuffer, tBufferSize, tReadBytes, tDescriptors, tDescriptorCount, tError);
+}
+/**
+ * Function for writing data along with file descriptors (SCM_RIGHTS) to the specified
+ * client. At least one byte of data has to be sent with the descriptors
+ * @param tSocket Client socket
+ * @param tSrcBuffer Buffer with the data to send
+ * @param tBufferSize Buffer size
+ * @param tDescriptors Descriptors to pass
+ * @param tDescriptorCount Number of descriptors
+ * @param tWrittenBytes Number of bytes actually written
+ * @param tError Failure details, filled only on failure (optional)
+ * @return Status
+ */
+dSocketResult dSocket::writeDescriptors(int tSocket, const uint8_t* tSrcBuffer, size_t tBufferSize, const int* tDescriptors, size_t tDescriptorCount, ssize_t* tWrittenBytes, dSocketError* tError) {
+    if (mType != dSocketType::SERVER) {
+        return reportError(dSocketOperation::WRITE_DESCRIPTORS, dSocketResult::WRONG_SOCKET_TYPE, 0, tError);
+    }
+
+    if (mProtocol != dSocketProtocol::UNIX_STREAM) {
+        return reportError(dSocketOperation::WRITE_DESCRIPTORS, dSocketResult::WRONG_PROTOCOL, 0, tError);
     }
 
     //----------//
 
-    ssize_t ReadBytes;
+    return sendDescriptors(tSocket, tSrcBuffer, tBufferSize, tDescriptors, tDescriptorCount, tWrittenBytes, tError);
+}
+//-----------------------------//
+/**
+ * Function for taking one pending transmit timestamp of this socket from the error queue.
+ * Does not block
+ * @param tTimestamp Transmit timestamp with the id of the data it belongs to
+ * @return Status (RECV_TIMEOUT if no timestamp is pending)
+ */
+dSocketResult dSocket::readTxTimestamp(dSocketTimestamp* tTimestamp) {
+    return readTxTimestamp(mSocket, tTimestamp);
+}
+/**
+ * Function for taking one pending transmit timestamp of the specified socket from the error
+ * queue. Does not block
+ * @param tSocket Socket (this socket or an accepted one)
+ * @param tTimestamp Transmit timestamp with the id of the data it belongs to
+ * @return Status (RECV_TIMEOUT if no timestamp is pending)
+ */
+dSocketResult dSocket::readTxTimestamp(int tSocket, dSocketTimestamp* tTimestamp) {
+    alignas(cmsghdr) uint8_t Control[256];
+    msghdr Message = {};
 
-    if ((ReadBytes = recvfrom(mSocket, tDstBuffer, tBufferSize, 0, tClientStruct, tClientStructSize)) == -1) {
-        if (mVerbose) {
-            mLastErrno = errno;
-            std::cerr << "dSocket::readUDP" << std::endl;
-        }
+    Message.msg_control     = Control;
+    Message.msg_controllen  = sizeof(Control);
 
+    if (recvmsg(tSocket, &Message, MSG_ERRQUEUE | MSG_DONTWAIT) == -1) {
         if (errno == EAGAIN || errno == EWOULDBLOCK) {
             return dSocketResult::RECV_TIMEOUT;
         }
 
-        return dSocketResult::READ_ERROR;
+        return reportError(dSocketOperation::READ_TX_TIMESTAMP, dSocketResult::READ_ERROR, errno);
+    }
+
+    *tTimestamp = {};
+
+    for (cmsghdr* Header = CMSG_FIRSTHDR(&Message); Header; Header = CMSG_NXTHDR(&Message, Header)) {
+        if (Header -> cmsg_level == SOL_SOCKET && Header -> cmsg_type == SCM_TIMESTAMPING) {
+            auto* Stamps = reinterpret_cast <scm_timestamping*>(CMSG_DATA(Header));
+
+            tTimestamp -> Software = static_cast <uint64_t>(Stamps -> ts[0].tv_sec) * 1000000000 + Stamps -> ts[0].tv_nsec;
+        } else if ((Header -> cmsg_level == SOL_IP && Header -> cmsg_type == IP_RECVERR) ||
+                   (Header -> cmsg_level == SOL_IPV6 && Header -> cmsg_type == IPV6_RECVERR)) {
+            auto* Error = reinterpret_cast <sock_extended_err*>(CMSG_DATA(Header));
+
+            if (Error -> ee_origin == SO_EE_ORIGIN_TIMESTAMPING) {
+                tTimestamp -> Id = Error -> ee_data;
+            }
+        }
     }
 
-    *tReadBytes = ReadBytes;
     return dSocketResult::SUCCESS;
 }
+
 /**
- * Function for writing data to the specified UDP client
- * @param tSrcBuffer Buffer with the data to send
- * @param tBufferSize Buffer size
- * @param tWrittenBytes Number of bytes actually written
- * @param tClientStruct Client data structure
- * @param tClientStructSize Client data structure size
+ * Function for taking a TCP_INFO snapshot of the connection to the server
+ * @param tInfo Snapshot
  * @return Status
  */
-dSocketResult dSocket::writeUDP(const uint8_t* tSrcBuffer, size_t tBufferSize, ssize_t* tWrittenBytes, const sockaddr* tClientStruct, socklen_t tClientStructSize) {
-    if (mType != dSocketType::SERVER) {
-        if (mVerbose) {
-            std::cerr << "dSocket::writeUDP" << std::endl;
-        }
-
-        return dSocketResult::WRONG_SOCKET_TYPE;
-    }
-
-    if (mProtocol != dSocketProtocol::UDP) {
-        if (mVerbose) {
-            std::cerr << "dSocket::writeUDP" << std::endl;
-        }
-
-        return dSocketResult::WRONG_PROTOCOL;
+dSocketResult dSocket::getTcpInfo(dSocketTcpInfo* tInfo) {
+    return getTcpInfo(mSocket, tInfo);
+}
+/**
+ * Function for taking a TCP_INFO snapshot of the specified connection
+ * @param tSocket Socket (this socket or an accepted one)
+ * @param tInfo Snapshot
+ * @return Status
+ */
+dSocketResult dSocket::getTcpInfo(int tSocket, dSocketTcpInfo* tInfo) {
+    if (mProtocol != dSocketProtocol::TCP) {
+        return reportError(dSocketOperation::GET_TCP_INFO, dSocketResult::WRONG_PROTOCOL);
     }
 
     //----------//
 
-    ssize_t WrittenBytes;
-
-    if ((WrittenBytes = sendto(mSocket, tSrcBuffer, tBufferSize, 0, tClientStruct, tClientStructSize)) == -1) {
-        if (mVerbose) {
-            mLastErrno = errno;
-            std::cerr << "dSocket::writeUDP" << std::endl;
-        }
+    tcp_info Info = {};
+    socklen_t Length = sizeof(Info);
 
-        return dSocketResult::WRITE_ERROR;
+    if (getsockopt(tSocket, IPPROTO_TCP, TCP_INFO, &Info, &Length) == -1) {
+        return reportError(dSocketOperation::GET_TCP_INFO, dSocketResult::GET_OPTION_FAILURE, errno);
     }
 
-    *tWrittenBytes = WrittenBytes;
+    tInfo -> Rtt            = Info.tcpi_rtt;
+    tInfo -> RttVariance    = Info.tcpi_rttvar;
+    tInfo -> Retransmits    = Info.tcpi_retransmits;
+    tInfo -> TotalRetrans   = Info.tcpi_total_retrans;
+    tInfo -> Lost           = Info.tcpi_lost;
+    tInfo -> Unacked        = Info.tcpi_unacked;
+    tInfo -> SendCwnd       = Info.tcpi_snd_cwnd;
+    tInfo -> SendSsthresh   = Info.tcpi_snd_ssthresh;
+    tInfo -> SendMss        = Info.tcpi_snd_mss;
+    tInfo -> ReceiveRtt     = Info.tcpi_rcv_rtt;
+    tInfo -> ReceiveSpace   = Info.tcpi_rcv_space;
+
     return dSocketResult::SUCCESS;
 }
 //-----------------------------//
 /**
- * Function return the latest errno value written in the mLastErrno variable
+ * Function for setting the sink failures are logged to. Failures are logged only in verbose
+ * mode or when a sink is set explicitly. By default verbose sockets use
+ * dSocketLogSink::instance(), which a background thread writes to stderr; an explicit sink
+ * has to be flushed by the application
+ * @param tSink Sink (nullptr to use the default one)
+ */
+void dSocket::setLogSink(dSocketLogSink* tSink) {
+    mLogSink = tSink;
+}
+/**
+ * Function for setting the capture every successful TCP / UDP read and write is recorded to,
+ * along with every accepted or connected stream (a zero-size ACCEPT / CONNECT record)
+ * @param tCapture Opened capture (nullptr to stop capturing)
+ */
+void dSocket::setCapture(dSocketCapture* tCapture) {
+    mCapture = tCapture;
+}
+/**
+ * Function return the latest errno value as a string
  * @return
  */
 std::string dSocket::getLastError() const {
-    switch (mLastErrno) {
+    return convertErrnoToString(getLastErrorInfo().Errno);
+}
+/**
+ * Function returns the latest failure. It is recorded regardless of verbose mode, but it is
+ * shared by every thread using this socket; to tell why a particular call failed pass a
+ * dSocketError to that call instead
+ * @return Result, operation and errno of the latest failure
+ */
+dSocketError dSocket::getLastErrorInfo() const {
+    return dSocketError::unpack(mLastError.load(std::memory_order_relaxed));
+}
+//-----------------------------//
+/**
+ * Function converts an errno value to its symbolic name
+ * @param tErrno errno value
+ * @return Symbolic name
+ */
+std::string dSocket::convertErrnoToString(int tErrno) {
+    switch (tErrno) {
         case 0:
             return "Success!";
         case EPERM:                             //---1---//
@@ -721,6 +2163,51 @@ std::string dSocket::getLastError() const {
             return "Unknown error!";
     }
 }
+/**
+ * Function converts an operation to the name of the function it is reported by
+ * @param tOperation Operation
+ * @return Function name
+ */
+std::string dSocket::convertOperationToString(dSocketOperation tOperation) {
+    switch (tOperation) {
+        case dSocketOperation::NONE:
+            return "dSocket";
+        case dSocketOperation::INIT:
+            return "dSocket::init";
+        case dSocketOperation::SET_OPTION:
+            return "dSocket::setOption";
+        case dSocketOperation::FINALIZE:
+            return "dSocket::finalize";
+        case dSocketOperation::ACCEPT:
+            return "dSocket::acceptConnection";
+        case dSocketOperation::CONNECT:
+            return "dSocket::connectToServer";
+        case dSocketOperation::READ_TCP:
+            return "dSocket::readTCP";
+        case dSocketOperation::WRITE_TCP:
+            return "dSocket::writeTCP";
+        case dSocketOperation::READ_UDP:
+            return "dSocket::readUDP";
+        case dSocketOperation::WRITE_UDP:
+            return "dSocket::writeUDP";
+        case dSocketOperation::READ_TX_TIMESTAMP:
+            return "dSocket::readTxTimestamp";
+        case dSocketOperation::GET_TCP_INFO:
+            return "dSocket::getTcpInfo";
+        case dSocketOperation::READ_DESCRIPTORS:
+            return "dSocket::readDescriptors";
+        case dSocketOperation::WRITE_DESCRIPTORS:
+            return "dSocket::writeDescriptors";
+        case dSocketOperation::SHARED_RING:
+            return "dSocketSharedRing";
+        case dSocketOperation::RPC:
+            return "dSocketRpc";
+        case dSocketOperation::CAPTURE:
+            return "dSocketCapture";
+    }
+
+    return "dSocket";
+}
 //-----------------------------//
 /**
  * Function converts x.x.x.x format IPv4 address to a 4-byte number for more
@@ -759,3 +2246,33 @@ std::string dSocket::convertUintToIpv4(uint32_t tAddress) {
 
     return std::to_string(A) + Delimiter + std::to_string(B) + Delimiter + std::to_string(C) + Delimiter + std::to_string(D);
 }
+//-----------------------------//
+/**
+ * Preset for latency-sensitive traffic: no Nagle, busy polling and a small unsent data
+ * threshold so that writes do not pile up in the kernel. TCP options are skipped on other
+ * protocols, so the preset works for UDP and Unix sockets too
+ * @return Profile
+ */
+dSocketOptionProfile dSocketOptionProfile::lowLatency() {
+    dSocketOptionProfile Profile;
+
+    Profile.BusyPoll        = 50;
+    Profile.NotSentLowAt    = 16 * 1024;
+    Profile.Priority        = 6;
+    Profile.NoDelay         = true;
+
+    return Profile;
+}
+/**
+ * Preset for bulk transfers: large kernel buffers and Nagle left enabled
+ * @return Profile
+ */
+dSocketOptionProfile dSocketOptionProfile::highThroughput() {
+    dSocketOptionProfile Profile;
+
+    Profile.ReceiveBuffer   = 4 * 1024 * 1024;
+    Profile.SendBuffer      = 4 * 1024 * 1024;
+    Profile.NoDelay         = false;
+
+    return Profile;
+}
@@ -7,13 +7,21 @@
 //-----------------------------//
 #include <iostream>
 #include <sstream>
+#include <vector>
+#include <optional>
+#include <atomic>
 #include <fcntl.h>
 //-----------------------------//
 #if __linux__
     #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <sys/stat.h>
     #include <arpa/inet.h>
     #include <netinet/tcp.h>
     #include <unistd.h>
+    #include <poll.h>
+    #include <linux/net_tstamp.h>
+    #include <linux/errqueue.h>
 #elif _WIN32
     #include <winsock2.h>
 #else
@@ -23,14 +31,16 @@
 enum class dSocketProtocol {
     UNDEFINED,
     TCP,
-    UDP
+    UDP,
+    UNIX_STREAM,
+    UNIX_DGRAM
 };
 enum class dSocketType {
     UNDEFINED,
     SERVER,
     CLIENT
 };
-enum class dSocketResult {
+enum class dSocketResult : uint16_t {
     SUCCESS                         = 0x0000,
     CREATE_FAILURE,
     WSA_FAILURE,
@@ -51,63 +61,280 @@ enum class dSocketResult {
     READ_ERROR,
     WRITE_ERROR,
     RECV_TIMEOUT,
+    ACCEPT_FAILURE,
+    ACCEPT_TIMEOUT,
+    NEGOTIATION_DECLINED,
+    TOO_MANY_REQUESTS,
+    REQUEST_TIMEOUT,
+    CONNECTION_CLOSED,
+    PROTOCOL_ERROR,
+    WOULD_BLOCK,
     UNKNOWN                         = 0xFFFF
 };
+enum class dSocketOperation : uint16_t {
+    NONE,
+    INIT,
+    SET_OPTION,
+    FINALIZE,
+    ACCEPT,
+    CONNECT,
+    READ_TCP,
+    WRITE_TCP,
+    READ_UDP,
+    WRITE_UDP,
+    READ_TX_TIMESTAMP,
+    GET_TCP_INFO,
+    READ_DESCRIPTORS,
+    WRITE_DESCRIPTORS,
+    SHARED_RING,
+    RPC,
+    CAPTURE
+};
+enum class dSocketOption {
+    RECEIVE_BUFFER,
+    SEND_BUFFER,
+    BUSY_POLL,
+    INCOMING_CPU,
+    QUICK_ACK,
+    NOT_SENT_LOW_AT,
+    PRIORITY,
+    NO_DELAY,
+    TIMESTAMPING
+};
+//-----------------------------//
+/**
+ * Compact failure record: result, failing operation and raw errno packed into 8 bytes so it
+ * can be stored and exchanged atomically
+ */
+struct dSocketError {
+    dSocketResult       Result          = dSocketResult::SUCCESS;
+    dSocketOperation    Operation       = dSocketOperation::NONE;
+    int32_t             Errno           = 0;
+
+    [[nodiscard]] uint64_t pack() const;
+    static dSocketError unpack(uint64_t tPacked);
+};
+struct dSocketOptionStatus {
+    dSocketOption       Option;
+    dSocketResult       Result;
+    int                 Errno;
+};
+/**
+ * Declarative set of socket options. Only the fields that are set are applied
+ */
+struct dSocketOptionProfile {
+    std::optional <int>     ReceiveBuffer;          //---SO_RCVBUF, bytes---//
+    std::optional <int>     SendBuffer;             //---SO_SNDBUF, bytes---//
+    std::optional <int>     BusyPoll;               //---SO_BUSY_POLL, microseconds---//
+    std::optional <int>     IncomingCpu;            //---SO_INCOMING_CPU, CPU index---//
+    std::optional <bool>    QuickAck;               //---TCP_QUICKACK (TCP only, not sticky: the kernel may reset it at any time)---//
+    std::optional <int>     NotSentLowAt;           //---TCP_NOTSENT_LOWAT, bytes (TCP only)---//
+    std::optional <int>     Priority;               //---SO_PRIORITY, 0..6 without CAP_NET_ADMIN---//
+    std::optional <bool>    NoDelay;                //---TCP_NODELAY (TCP only)---//
+    std::optional <bool>    Timestamping;           //---SO_TIMESTAMPING, software RX / TX---//
+
+    static dSocketOptionProfile lowLatency();
+    static dSocketOptionProfile highThroughput();
+};
+/**
+ * Kernel software timestamp of a received or sent piece of data
+ */
+struct dSocketTimestamp {
+    uint64_t            Software        = 0;            //---CLOCK_REALTIME, nanoseconds (0 if not available)---//
+    uint32_t            Id              = 0;            //---TX only: byte offset (TCP) or datagram counter (UDP)---//
+};
+/**
+ * Subset of TCP_INFO useful for latency attribution
+ */
+struct dSocketTcpInfo {
+    uint32_t            Rtt             = 0;            //---Smoothed RTT, microseconds---//
+    uint32_t            RttVariance     = 0;            //---Microseconds---//
+    uint32_t            ReceiveRtt      = 0;            //---Receiver-side RTT estimate, microseconds---//
+    uint32_t            Retransmits     = 0;            //---Currently unrecovered retransmits---//
+    uint32_t            TotalRetrans    = 0;
+    uint32_t            Lost            = 0;
+    uint32_t            Unacked         = 0;
+    uint32_t            SendCwnd        = 0;            //---Segments---//
+    uint32_t            SendSsthresh    = 0;
+    uint32_t            SendMss         = 0;
+    uint32_t            ReceiveSpace    = 0;
+};
+//-----------------------------//
+/**
+ * Move-only owner of an accepted connection socket. The socket is closed on destruction
+ */
+class dSocketConnection {
+public:
+    dSocketConnection() = default;
+    dSocketConnection(int32_t tSocket, const sockaddr_in& tStruct) : mSocket(tSocket), mStruct(tStruct) {}
+    ~dSocketConnection();
+
+    dSocketConnection(const dSocketConnection&) = delete;
+    dSocketConnection& operator=(const dSocketConnection&) = delete;
+
+    dSocketConnection(dSocketConnection&& tOther) noexcept;
+    dSocketConnection& operator=(dSocketConnection&& tOther) noexcept;
+
+    //----------//
+
+    [[nodiscard]] int32_t getNativeHandle() const { return mSocket; }
+    [[nodiscard]] const sockaddr_in& getPeerStruct() const { return mStruct; }
+    [[nodiscard]] bool isValid() const { return mSocket >= 0; }
+
+    int32_t release();
+    void close();
+private:
+    int32_t             mSocket         = -1;
+    sockaddr_in         mStruct         = {};
+};
+//-----------------------------//
+class dSocketLogSink;
+class dSocketSendQueue;
+class dSocketCapture;
 //-----------------------------//
 class dSocket {
 public:
     explicit dSocket(bool tVerbose = false) : mVerbose(tVerbose) {}
     ~dSocket();
 
+    dSocket(const dSocket&) = delete;
+    dSocket& operator=(const dSocket&) = delete;
+
+    dSocket(dSocket&& tOther) noexcept;
+    dSocket& operator=(dSocket&& tOther) noexcept;
+
     //----------//
 
     dSocketResult init(dSocketProtocol tProtocol);
 
     [[nodiscard]] dSocketResult setNoDelayOption(bool tEnable);
     [[nodiscard]] dSocketResult setReuseOption(bool tEnable);
+    [[nodiscard]] dSocketResult setDeferAcceptOption(uint32_t tTimeoutSec);
+    [[nodiscard]] dSocketResult setFastOpenOption(int tQueueLength);
+
+    [[nodiscard]] dSocketResult setTimestampingOption(bool tEnable);
+    [[nodiscard]] dSocketResult setMulticastLoopOption(bool tEnable);
+    [[nodiscard]] dSocketResult setMulticastTtlOption(uint8_t tTtl);
+    [[nodiscard]] dSocketResult setMulticastInterfaceOption(const std::string& tInterfaceAddress);
+
+    void setListenBacklog(int tBacklog);
+
+    dSocketResult setOptionProfile(const dSocketOptionProfile& tProfile, std::vector <dSocketOptionStatus>* tStatus = nullptr);
+    dSocketResult applyOptionProfile(int tSocket, std::vector <dSocketOptionStatus>* tStatus = nullptr);
 
     dSocketResult finalize(dSocketType tType, uint16_t tPort, const std::string& tServerAddress = "");
 
     int acceptConnection();
+    dSocketResult acceptConnection(dSocketConnection* tConnection, int tTimeoutMs = -1);
+    dSocketResult acceptConnections(std::vector <dSocketConnection>* tConnections, int tTimeoutMs = -1);
     dSocketResult connectToServer(uint32_t tTimeoutMs);
 
+    static dSocketResult createPair(dSocketProtocol tProtocol, dSocket* tFirst, dSocket* tSecond);
+
+    dSocketResult joinMulticastGroup(const std::string& tGroupAddress, const std::string& tInterfaceAddress = "");
+    dSocketResult leaveMulticastGroup(const std::string& tGroupAddress, const std::string& tInterfaceAddress = "");
+
     //----------//
 
-    dSocketResult readTCP(uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes);
-    dSocketResult writeTCP(const uint8_t* tSrcBuffer, size_t tBufferSize, ssize_t* tWrittenBytes);
+    dSocketResult readTCP(uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes, dSocketError* tError = nullptr);
+    dSocketResult writeTCP(const uint8_t* tSrcBuffer, size_t tBufferSize, ssize_t* tWrittenBytes, dSocketError* tError = nullptr);
 
-    dSocketResult readTCP(int tSocket, uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes);
-    dSocketResult writeTCP(int tSocket, const uint8_t* tSrcBuffer, size_t tBufferSize, ssize_t* tWrittenBytes);
+    dSocketResult readTCP(int tSocket, uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes, dSocketError* tError = nullptr);
+    dSocketResult writeTCP(int tSocket, const uint8_t* tSrcBuffer, size_t tBufferSize, ssize_t* tWrittenBytes, dSocketError* tError = nullptr);
+
+    dSocketResult readTCP(uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes, dSocketTimestamp* tTimestamp, dSocketError* tError = nullptr);
+    dSocketResult readTCP(int tSocket, uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes, dSocketTimestamp* tTimestamp, dSocketError* tError = nullptr);
+
+    dSocketResult writeQueuedTCP(dSocketSendQueue* tQueue, ssize_t* tWrittenBytes, dSocketError* tError = nullptr);
+    dSocketResult writeQueuedTCP(int tSocket, dSocketSendQueue* tQueue, ssize_t* tWrittenBytes, dSocketError* tError = nullptr);
 
     //----------//
 
-    dSocketResult readUDP(uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes);
-    dSocketResult writeUDP(const uint8_t* tSrcBuffer, size_t tBufferSize, ssize_t* tWrittenBytes);
+    dSocketResult readUDP(uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes, dSocketError* tError = nullptr);
+    dSocketResult writeUDP(const uint8_t* tSrcBuffer, size_t tBufferSize, ssize_t* tWrittenBytes, dSocketError* tError = nullptr);
+
+    dSocketResult readUDP(uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes, sockaddr* tClientStruct, socklen_t* tClientStructSize, dSocketError* tError = nullptr);
+    dSocketResult writeUDP(const uint8_t* tSrcBuffer, size_t tBufferSize, ssize_t* tWrittenBytes, const sockaddr* tClientStruct, socklen_t tClientStructSize, dSocketError* tError = nullptr);
 
-    dSocketResult readUDP(uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes, sockaddr* tClientStruct, socklen_t* tClientStructSize);
-    dSocketResult writeUDP(const uint8_t* tSrcBuffer, size_t tBufferSize, ssize_t* tWrittenBytes, const sockaddr* tClientStruct, socklen_t tClientStructSize);
+    dSocketResult readUDP(uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes, dSocketTimestamp* tTimestamp, dSocketError* tError = nullptr);
+    dSocketResult readUDP(uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes, sockaddr* tClientStruct, socklen_t* tClientStructSize, dSocketTimestamp* tTimestamp, dSocketError* tError = nullptr);
+
+    dSocketResult fanOutUDP(const uint8_t* tSrcBuffer, size_t tBufferSize, const sockaddr_in* tPeers, size_t tPeerCount, size_t* tSentCount,
+                            std::vector <size_t>* tFailedPeers = nullptr, dSocketError* tError = nullptr);
+
+    //----------//
+
+    dSocketResult readDescriptors(uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes, int* tDescriptors, size_t* tDescriptorCount, dSocketError* tError = nullptr);
+    dSocketResult writeDescriptors(const uint8_t* tSrcBuffer, size_t tBufferSize, const int* tDescriptors, size_t tDescriptorCount, ssize_t* tWrittenBytes, dSocketError* tError = nullptr);
+
+    dSocketResult readDescriptors(int tSocket, uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes, int* tDescriptors, size_t* tDescriptorCount, dSocketError* tError = nullptr);
+    dSocketResult writeDescriptors(int tSocket, const uint8_t* tSrcBuffer, size_t tBufferSize, const int* tDescriptors, size_t tDescriptorCount, ssize_t* tWrittenBytes, dSocketError* tError = nullptr);
 
     //----------//
 
+    dSocketResult readTxTimestamp(dSocketTimestamp* tTimestamp);
+    dSocketResult readTxTimestamp(int tSocket, dSocketTimestamp* tTimestamp);
+
+    dSocketResult getTcpInfo(dSocketTcpInfo* tInfo);
+    dSocketResult getTcpInfo(int tSocket, dSocketTcpInfo* tInfo);
+
+    //----------//
+
+    void setLogSink(dSocketLogSink* tSink);
+    void setCapture(dSocketCapture* tCapture);
+
     [[nodiscard]] std::string getLastError() const;
+    [[nodiscard]] dSocketError getLastErrorInfo() const;
+    [[nodiscard]] int32_t getNativeHandle() const { return mSocket; }
+    [[nodiscard]] dSocketProtocol getProtocol() const { return mProtocol; }
 
     //----------//
 
     static uint32_t convertIpv4ToUint(const std::string& tAddress);
     static std::string convertUintToIpv4(uint32_t tAddress);
+
+    static std::string convertErrnoToString(int tErrno);
+    static std::string convertOperationToString(dSocketOperation tOperation);
 private:
+    dSocketResult waitForConnection(int tTimeoutMs);
+    void closeSocket();
+    int removeStalePath(const sockaddr_un* tStruct) const;
+    static bool findBoundPath(const char* tPath, const struct stat& tStatus, bool* tBound);
+
+    static bool isStreamProtocol(dSocketProtocol tProtocol);
+    static bool isDatagramProtocol(dSocketProtocol tProtocol);
+
+    dSocketResult changeMembership(int tOption, const std::string& tGroupAddress, const std::string& tInterfaceAddress);
+    int setTimestamping(int tSocket, bool tEnable);
+    void prepareAcceptedSocket(int tSocket);
+    dSocketResult receiveTimestamped(dSocketOperation tOperation, int tSocket, uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes, sockaddr* tStruct, socklen_t* tStructSize, dSocketTimestamp* tTimestamp, dSocketError* tError);
+    dSocketResult receiveDescriptors(int tSocket, uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes, int* tDescriptors, size_t* tDescriptorCount, dSocketError* tError);
+    dSocketResult sendDescriptors(int tSocket, const uint8_t* tSrcBuffer, size_t tBufferSize, const int* tDescriptors, size_t tDescriptorCount, ssize_t* tWrittenBytes, dSocketError* tError);
+    dSocketResult flushQueue(int tSocket, dSocketSendQueue* tQueue, ssize_t* tWrittenBytes, dSocketError* tError);
+
+    dSocketResult reportError(dSocketOperation tOperation, dSocketResult tResult, int tErrno = 0, dSocketError* tError = nullptr);
+
 #if __linux__
-    int32_t             mSocket         = 0;
+    int32_t             mSocket         = -1;
 #elif _WIN32
     WSAData         mWSA;
-    SOCKET          mSocket     = 0;
+    SOCKET          mSocket     = INVALID_SOCKET;
 #endif
-    sockaddr_in         mStruct         = {};
+    sockaddr_storage    mStruct         = {};
+    socklen_t           mStructSize     = 0;
     dSocketType         mType           = dSocketType::UNDEFINED;
     dSocketProtocol     mProtocol       = dSocketProtocol::UNDEFINED;
     bool                mVerbose        = false;
+    int                 mBacklog        = SOMAXCONN;
+    bool                mTimestampingPending    = false;
+    bool                mOwnsPath               = false;     //---Unix server created the file at mStruct---//
+
+    std::optional <dSocketOptionProfile>    mProfile;
+
+    dSocketLogSink*     mLogSink        = nullptr;
+    dSocketCapture*     mCapture        = nullptr;
 
-    int                 mLastErrno      = 0;
+    std::atomic <uint64_t>  mLastError  = 0;
 };
 //-----------------------------//
 #endif
\ No newline at end of file
@@ -0,0 +1,240 @@
+//-----------------------------//
+#include <algorithm>
+#include <chrono>
+#include <new>
+#include <thread>
+//-----------------------------//
+#include <sys/mman.h>
+#include <sys/stat.h>
+//-----------------------------//
+#include "dSocketCapture.h"
+//-----------------------------//
+constexpr uint64_t  CaptureMagic        = 0x6574704353536444;
+constexpr uint32_t  CaptureVersion      = 1;
+//-----------------------------//
+dSocketCapture::~dSocketCapture() {
+    close();
+}
+//-----------------------------//
+/**
+ * Function for creating (or overwriting) a capture file
+ * @param tPath File path
+ * @param tCapacity Maximum number of records
+ * @return Status
+ */
+dSocketResult dSocketCapture::open(const std::string& tPath, size_t tCapacity) {
+    if (mMapping) {
+        return reportError(dSocketResult::CREATE_FAILURE, EBUSY);
+    }
+
+    if (tCapacity == 0) {
+        return reportError(dSocketResult::CREATE_FAILURE, EINVAL);
+    }
+
+    //----------//
+
+    size_t MappingSize = sizeof(Header) + tCapacity * sizeof(dSocketCaptureRecord);
+    int Descriptor;
+
+    if ((Descriptor = ::open(tPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)) == -1) {
+        return reportError(dSocketResult::CREATE_FAILURE, errno);
+    }
+
+    if (ftruncate(Descriptor, static_cast <off_t>(MappingSize)) == -1) {
+        int Errno = errno;
+        ::close(Descriptor);
+
+        return reportError(dSocketResult::CREATE_FAILURE, Errno);
+    }
+
+    void* Mapping;
+
+    if ((Mapping = mmap(nullptr, MappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, Descriptor, 0)) == MAP_FAILED) {
+        int Errno = errno;
+        ::close(Descriptor);
+
+        return reportError(dSocketResult::CREATE_FAILURE, Errno);
+    }
+
+    //---A fresh file is zero-filled, so every record starts as NONE---//
+
+    mDescriptor     = Descriptor;
+    mMapping        = new (Mapping) Header;
+    mMappingSize    = MappingSize;
+    mRecords        = reinterpret_cast <dSocketCaptureRecord*>(static_cast <uint8_t*>(Mapping) + sizeof(Header));
+    mCapacity       = tCapacity;
+
+    mMapping -> Magic       = CaptureMagic;
+    mMapping -> Version     = CaptureVersion;
+    mMapping -> RecordSize  = sizeof(dSocketCaptureRecord);
+    mMapping -> Capacity    = tCapacity;
+
+    mMapping -> Next.store(0, std::memory_order_relaxed);
+    mMapping -> Dropped.store(0, std::memory_order_relaxed);
+
+    mOpen.store(true, std::memory_order_seq_cst);
+
+    return dSocketResult::SUCCESS;
+}
+/**
+ * Function for closing the capture file and trimming it to the recorded part. May run while
+ * other threads record: new records are refused and the ones in flight are waited for
+ */
+void dSocketCapture::close() {
+    if (!mMapping) {
+        return;
+    }
+
+    //---Pairs with record: a writer either sees mOpen cleared or is counted in mWriters---//
+
+    mOpen.store(false, std::memory_order_seq_cst);
+
+    while (mWriters.load(std::memory_order_seq_cst) != 0) {
+        std::this_thread::yield();
+    }
+
+    uint64_t Count = std::min(mMapping -> Next.load(std::memory_order_acquire), mCapacity);
+
+    munmap(mMapping, mMappingSize);
+    [[maybe_unused]] auto Unused = ftruncate(mDescriptor, static_cast <off_t>(sizeof(Header) + Count * sizeof(dSocketCaptureRecord)));
+    ::close(mDescriptor);
+
+    mDescriptor     = -1;
+    mMapping        = nullptr;
+    mMappingSize    = 0;
+    mRecords        = nullptr;
+    mCapacity       = 0;
+}
+//-----------------------------//
+/**
+ * Function for recording one completed read / write or the start of a connection, safe to
+ * call from any thread, also while close runs. Records made after close are ignored
+ * @param tOperation READ_TCP / WRITE_TCP / READ_UDP / WRITE_UDP, ACCEPT / CONNECT
+ * @param tSocket Socket the data went through
+ * @param tBytes Number of bytes read or written (0 for ACCEPT / CONNECT)
+ */
+void dSocketCapture::record(dSocketOperation tOperation, int32_t tSocket, ssize_t tBytes) {
+    mWriters.fetch_add(1, std::memory_order_seq_cst);
+
+    if (!mOpen.load(std::memory_order_seq_cst)) {
+        mWriters.fetch_sub(1, std::memory_order_release);
+        return;
+    }
+
+    uint64_t Slot = mMapping -> Next.fetch_add(1, std::memory_order_relaxed);
+
+    if (Slot >= mCapacity) {
+        mMapping -> Dropped.fetch_add(1, std::memory_order_relaxed);
+        mWriters.fetch_sub(1, std::memory_order_release);
+        return;
+    }
+
+    dSocketCaptureRecord& Target = mRecords[Slot];
+
+    Target.Timestamp    = std::chrono::duration_cast <std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    Target.Size         = static_cast <uint32_t>(tBytes);
+    Target.Socket       = tSocket;
+
+    //---Publishing the operation last marks the record as complete---//
+
+    __atomic_store_n(reinterpret_cast <uint16_t*>(&Target.Operation), static_cast <uint16_t>(tOperation), __ATOMIC_RELEASE);
+
+    mWriters.fetch_sub(1, std::memory_order_release);
+}
+//-----------------------------//
+/**
+ * Function returns the number of records written so far
+ * @return Record count
+ */
+uint64_t dSocketCapture::getRecordedCount() const {
+    if (!mMapping) {
+        return 0;
+    }
+
+    return std::min(mMapping -> Next.load(std::memory_order_relaxed), mCapacity);
+}
+/**
+ * Function returns the number of records dropped because the file was full
+ * @return Record count
+ */
+uint64_t dSocketCapture::getDroppedCount() const {
+    if (!mMapping) {
+        return 0;
+    }
+
+    return mMapping -> Dropped.load(std::memory_order_relaxed);
+}
+//-----------------------------//
+/**
+ * Function for reading a capture file. Records that were not completely written are skipped
+ * @param tPath File path
+ * @param tRecords Records in the order their slots were reserved
+ * @param tDroppedCount Number of records dropped during capture (optional)
+ * @return Status
+ */
+dSocketResult dSocketCapture::load(const std::string& tPath, std::vector <dSocketCaptureRecord>* tRecords, uint64_t* tDroppedCount) {
+    int Descriptor;
+
+    if ((Descriptor = ::open(tPath.c_str(), O_RDONLY | O_CLOEXEC)) == -1) {
+        return dSocketResult::READ_ERROR;
+    }
+
+    struct stat Status = {};
+
+    if (fstat(Descriptor, &Status) == -1 || static_cast <size_t>(Status.st_size) < sizeof(Header)) {
+        ::close(Descriptor);
+        return dSocketResult::READ_ERROR;
+    }
+
+    void* Mapping;
+
+    if ((Mapping = mmap(nullptr, Status.st_size, PROT_READ, MAP_SHARED, Descriptor, 0)) == MAP_FAILED) {
+        ::close(Descriptor);
+        return dSocketResult::READ_ERROR;
+    }
+
+    ::close(Descriptor);
+
+    //----------//
+
+    auto* FileHeader = static_cast <const Header*>(Mapping);
+
+    if (FileHeader -> Magic != CaptureMagic || FileHeader -> Version != CaptureVersion || FileHeader -> RecordSize != sizeof(dSocketCaptureRecord)) {
+        munmap(Mapping, Status.st_size);
+        return dSocketResult::PROTOCOL_ERROR;
+    }
+
+    uint64_t Count = std::min({
+            FileHeader -> Next.load(std::memory_order_acquire),
+            FileHeader -> Capacity,
+            static_cast <uint64_t>((Status.st_size - sizeof(Header)) / sizeof(dSocketCaptureRecord))
+    });
+    auto* Records = reinterpret_cast <const dSocketCaptureRecord*>(static_cast <const uint8_t*>(Mapping) + sizeof(Header));
+
+    tRecords -> clear();
+    tRecords -> reserve(Count);
+
+    for (uint64_t i = 0; i < Count; i++) {
+        if (Records[i].Operation != dSocketOperation::NONE) {
+            tRecords -> push_back(Records[i]);
+        }
+    }
+
+    if (tDroppedCount) {
+        *tDroppedCount = FileHeader -> Dropped.load(std::memory_order_relaxed);
+    }
+
+    munmap(Mapping, Status.st_size);
+
+    return dSocketResult::SUCCESS;
+}
+//-----------------------------//
+dSocketResult dSocketCapture::reportError(dSocketResult tResult, int tErrno) {
+    mLastError = {
+            .Result = tResult,
+            .Operation = dSocketOperation::CAPTURE,
+            .Errno = tErrno
+    };
+
+    return tResult;
+}
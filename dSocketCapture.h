@@ -0,0 +1,80 @@
+//-----------------------------//
+#ifndef DSOCKETCAPTURE_H
+#define DSOCKETCAPTURE_H
+//-----------------------------//
+#include "dSocket.h"
+//-----------------------------//
+/**
+ * One captured read / write: when it completed, on which socket and how many bytes moved.
+ * ACCEPT / CONNECT records (Size 0) mark a new connection on a possibly reused descriptor.
+ * Payloads are not captured
+ */
+struct dSocketCaptureRecord {
+    uint64_t            Timestamp       = 0;            //---steady_clock, nanoseconds---//
+    uint32_t            Size            = 0;
+    int32_t             Socket          = -1;
+    dSocketOperation    Operation       = dSocketOperation::NONE;   //---NONE while the record is being written---//
+    uint16_t            Reserved        = 0;
+    uint32_t            Padding         = 0;
+};
+//-----------------------------//
+/**
+ * Traffic capture hook for dSocket::setCapture. Records are appended to a fixed-size file
+ * mapped into memory: a writer reserves a slot with a single atomic increment and fills it in
+ * place, so capturing never blocks and never makes a system call. When the file is full
+ * further records are dropped and counted. The file is trimmed to the recorded part on close
+ * and can be read back with load (see replay.cpp)
+ */
+class dSocketCapture {
+public:
+    dSocketCapture() = default;
+    ~dSocketCapture();
+
+    dSocketCapture(const dSocketCapture&) = delete;
+    dSocketCapture& operator=(const dSocketCapture&) = delete;
+
+    //----------//
+
+    dSocketResult open(const std::string& tPath, size_t tCapacity);
+    void close();
+
+    void record(dSocketOperation tOperation, int32_t tSocket, ssize_t tBytes);
+
+    [[nodiscard]] bool isOpen() const { return mOpen.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint64_t getRecordedCount() const;
+    [[nodiscard]] uint64_t getDroppedCount() const;
+    [[nodiscard]] dSocketError getLastErrorInfo() const { return mLastError; }
+
+    //----------//
+
+    static dSocketResult load(const std::string& tPath, std::vector <dSocketCaptureRecord>* tRecords, uint64_t* tDroppedCount = nullptr);
+private:
+    struct Header {
+        uint64_t                Magic;
+        uint32_t                Version;
+        uint32_t                RecordSize;
+        uint64_t                Capacity;
+
+        alignas(64) std::atomic <uint64_t>  Next;           //---Next free slot, may exceed Capacity---//
+        alignas(64) std::atomic <uint64_t>  Dropped;
+    };
+
+    //----------//
+
+    dSocketResult reportError(dSocketResult tResult, int tErrno = 0);
+
+    //----------//
+
+    int                     mDescriptor     = -1;
+    Header*                 mMapping        = nullptr;
+    size_t                  mMappingSize    = 0;
+    dSocketCaptureRecord*   mRecords        = nullptr;
+    uint64_t                mCapacity       = 0;
+
+    std::atomic <bool>      mOpen           = false;
+    std::atomic <uint32_t>  mWriters        = 0;        //---Threads inside record---//
+
+    dSocketError            mLastError;
+};
+//-----------------------------//
+#endif
@@ -0,0 +1,147 @@
+//-----------------------------//
+#include <chrono>
+#include <mutex>
+#include <thread>
+//-----------------------------//
+#include "dSocketLogSink.h"
+//-----------------------------//
+/**
+ * @param tCapacity Number of records, rounded up to a power of two
+ */
+dSocketLogSink::dSocketLogSink(size_t tCapacity) {
+    size_t Capacity = 2;
+
+    while (Capacity < tCapacity) {
+        Capacity <<= 1;
+    }
+
+    mCells = std::make_unique <Cell[]>(Capacity);
+    mMask = Capacity - 1;
+
+    for (size_t i = 0; i < Capacity; i++) {
+        mCells[i].Sequence.store(i, std::memory_order_relaxed);
+    }
+}
+//-----------------------------//
+/**
+ * Function for adding a record without blocking
+ * @param tError Failure
+ * @param tSocket Socket the failure happened on
+ * @return false if the ring was full and the record was dropped
+ */
+bool dSocketLogSink::push(const dSocketError& tError, int32_t tSocket) {
+    size_t Position = mEnqueuePos.load(std::memory_order_relaxed);
+    Cell* Target;
+
+    while (true) {
+        Target = &mCells[Position & mMask];
+
+        size_t Sequence = Target -> Sequence.load(std::memory_order_acquire);
+        auto Difference = static_cast <intptr_t>(Sequence) - static_cast <intptr_t>(Position);
+
+        if (Difference == 0) {
+            if (mEnqueuePos.compare_exchange_weak(Position, Position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (Difference < 0) {
+            mDropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            Position = mEnqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    Target -> Entry.Error       = tError;
+    Target -> Entry.Socket      = tSocket;
+    Target -> Entry.Timestamp   = std::chrono::duration_cast <std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    Target -> Sequence.store(Position + 1, std::memory_order_release);
+    return true;
+}
+/**
+ * Function for taking the oldest record
+ * @param tEntry Record
+ * @return false if the ring was empty
+ */
+bool dSocketLogSink::pop(dSocketLogEntry* tEntry) {
+    size_t Position = mDequeuePos.load(std::memory_order_relaxed);
+    Cell* Target;
+
+    while (true) {
+        Target = &mCells[Position & mMask];
+
+        size_t Sequence = Target -> Sequence.load(std::memory_order_acquire);
+        auto Difference = static_cast <intptr_t>(Sequence) - static_cast <intptr_t>(Position + 1);
+
+        if (Difference == 0) {
+            if (mDequeuePos.compare_exchange_weak(Position, Position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (Difference < 0) {
+            return false;
+        } else {
+            Position = mDequeuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    *tEntry = Target -> Entry;
+
+    Target -> Sequence.store(Position + mMask + 1, std::memory_order_release);
+    return true;
+}
+/**
+ * Function for writing all pending records to the stream, one per line
+ * @param tStream Output stream
+ * @return Number of written records
+ */
+size_t dSocketLogSink::flush(std::ostream& tStream) {
+    dSocketLogEntry Entry;
+    size_t Count = 0;
+
+    while (pop(&Entry)) {
+        tStream << dSocket::convertOperationToString(Entry.Error.Operation)
+                << " (socket " << Entry.Socket
+                << ", result " << static_cast <uint16_t>(Entry.Error.Result)
+                << ", " << dSocket::convertErrnoToString(Entry.Error.Errno) << ")\n";
+        Count++;
+    }
+
+    tStream.flush();
+    return Count;
+}
+//-----------------------------//
+/**
+ * Function returns the number of records dropped because the ring was full
+ * @return Dropped record count
+ */
+uint64_t dSocketLogSink::getDroppedCount() const {
+    return mDropped.load(std::memory_order_relaxed);
+}
+//-----------------------------//
+/**
+ * Function returns the process-wide sink used by verbose sockets by default. It is drained
+ * to stderr by a background thread started on first use (see startDefaultFlusher)
+ * @return Sink
+ */
+dSocketLogSink& dSocketLogSink::instance() {
+    static auto* Sink = new dSocketLogSink;         //---Never destroyed, the flusher may outlive static destruction---//
+    return *Sink;
+}
+/**
+ * Function for starting, once per process, the thread that writes the default sink to
+ * stderr every DefaultFlushPeriodMs, so verbose sockets print without the application
+ * calling flush
+ */
+void dSocketLogSink::startDefaultFlusher() {
+    static std::once_flag Started;
+
+    std::call_once(Started, [] {
+        std::thread([] {
+            while (true) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(DefaultFlushPeriodMs));
+                instance().flush(std::cerr);
+            }
+        }).detach();
+    });
+}
@@ -0,0 +1,57 @@
+//-----------------------------//
+#ifndef DSOCKETLOGSINK_H
+#define DSOCKETLOGSINK_H
+//-----------------------------//
+#include <memory>
+//-----------------------------//
+#include "dSocket.h"
+//-----------------------------//
+struct dSocketLogEntry {
+    dSocketError        Error;
+    int32_t             Socket          = -1;
+    uint64_t            Timestamp       = 0;            //---steady_clock, nanoseconds---//
+};
+//-----------------------------//
+/**
+ * Bounded lock-free multi-producer multi-consumer ring of failure records. Producers never
+ * block: when the ring is full the record is dropped and counted. Records are written out by
+ * whoever calls flush, normally a low-priority logging thread; the default sink has its own
+ */
+class dSocketLogSink {
+public:
+    static constexpr int DefaultFlushPeriodMs = 50;
+
+    explicit dSocketLogSink(size_t tCapacity = 4096);
+    ~dSocketLogSink() = default;
+
+    dSocketLogSink(const dSocketLogSink&) = delete;
+    dSocketLogSink& operator=(const dSocketLogSink&) = delete;
+
+    //----------//
+
+    bool push(const dSocketError& tError, int32_t tSocket);
+    bool pop(dSocketLogEntry* tEntry);
+
+    size_t flush(std::ostream& tStream);
+
+    [[nodiscard]] uint64_t getDroppedCount() const;
+
+    //----------//
+
+    static dSocketLogSink& instance();
+    static void startDefaultFlusher();
+private:
+    struct Cell {
+        std::atomic <size_t>    Sequence;
+        dSocketLogEntry         Entry;
+    };
+
+    std::unique_ptr <Cell[]>    mCells;
+    size_t                      mMask;
+
+    alignas(64) std::atomic <size_t>    mEnqueuePos     = 0;
+    alignas(64) std::atomic <size_t>    mDequeuePos     = 0;
+    alignas(64) std::atomic <uint64_t>  mDropped        = 0;
+};
+//-----------------------------//
+#endif
@@ -0,0 +1,616 @@
+//-----------------------------//
+#include <cstring>
+//-----------------------------//
+#include <endian.h>
+#include <sys/eventfd.h>
+//-----------------------------//
+#include "dSocketRpc.h"
+//-----------------------------//
+constexpr size_t    RpcHeaderSize       = 16;       //---Request ID (8), payload length (4), status (4), big-endian---//
+constexpr size_t    RpcReadChunk        = 64 * 1024;
+//-----------------------------//
+static void encodeHeader(uint8_t* tHeader, uint64_t tRequestId, uint32_t tLength, uint32_t tStatus) {
+    uint64_t RequestId  = htobe64(tRequestId);
+    uint32_t Length     = htobe32(tLength);
+    uint32_t Status     = htobe32(tStatus);
+
+    std::memcpy(tHeader, &RequestId, 8);
+    std::memcpy(tHeader + 8, &Length, 4);
+    std::memcpy(tHeader + 12, &Status, 4);
+}
+static void decodeHeader(const uint8_t* tHeader, uint64_t* tRequestId, uint32_t* tLength, uint32_t* tStatus) {
+    uint64_t RequestId;
+    uint32_t Length;
+    uint32_t Status;
+
+    std::memcpy(&RequestId, tHeader, 8);
+    std::memcpy(&Length, tHeader + 8, 4);
+    std::memcpy(&Status, tHeader + 12, 4);
+
+    *tRequestId = be64toh(RequestId);
+    *tLength    = be32toh(Length);
+    *tStatus    = be32toh(Status);
+}
+/**
+ * Function for waiting until a server connection becomes writable again after a partial flush
+ */
+static void waitWritable(int tSocket) {
+    pollfd Descriptor {
+            .fd = tSocket,
+            .events = POLLOUT,
+            .revents = 0
+    };
+
+    while (poll(&Descriptor, 1, -1) == -1 && errno == EINTR) {}
+}
+//-----------------------------//
+dSocketRpcClient::~dSocketRpcClient() {
+    stop();
+}
+//-----------------------------//
+/**
+ * Function for starting the receiver thread on a connected socket. The socket must not be
+ * read by anybody else until stop is called
+ * @param tSocket Connected TCP or Unix stream client socket
+ * @param tMaxOutstanding Number of requests that can wait for a response at the same time,
+ * further calls fail with TOO_MANY_REQUESTS
+ * @param tMaxPayload Largest accepted response payload, larger ones close the connection
+ * @param tMaxQueuedBytes Number of request bytes that can wait to be sent at the same time,
+ * further calls fail with TOO_MANY_REQUESTS
+ * @return Status
+ */
+dSocketResult dSocketRpcClient::start(dSocket* tSocket, size_t tMaxOutstanding, size_t tMaxPayload, size_t tMaxQueuedBytes) {
+    if (mReceiver.joinable()) {
+        bool Running;
+
+        {
+            std::lock_guard <std::mutex> Lock(mMutex);
+            Running = mRunning;
+        }
+
+        if (Running) {
+            return reportError(dSocketResult::CREATE_FAILURE, EBUSY);
+        }
+
+        //---Finish a stop that was requested from a callback---//
+
+        stop();
+    }
+
+    if (tSocket -> getNativeHandle() < 0) {
+        return reportError(dSocketResult::CONNECTION_CLOSED, EBADF);
+    }
+
+    if (tSocket -> getProtocol() != dSocketProtocol::TCP && tSocket -> getProtocol() != dSocketProtocol::UNIX_STREAM) {
+        return reportError(dSocketResult::WRONG_PROTOCOL);
+    }
+
+    //---The receiver thread does all the writing and must never block in sendmsg---//
+
+    int Flags;
+
+    if ((Flags = fcntl(tSocket -> getNativeHandle(), F_GETFL, nullptr)) < 0) {
+        return reportError(dSocketResult::GET_FLAGS_FAILURE, errno);
+    }
+
+    if ((mWakeDescriptor = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1) {
+        return reportError(dSocketResult::CREATE_FAILURE, errno);
+    }
+
+    if (fcntl(tSocket -> getNativeHandle(), F_SETFL, Flags | O_NONBLOCK) < 0) {
+        int Errno = errno;
+
+        ::close(mWakeDescriptor);
+        mWakeDescriptor = -1;
+
+        return reportError(dSocketResult::SET_FLAGS_FAILURE, Errno);
+    }
+
+    //----------//
+
+    mSocket         = tSocket;
+    mSocketFlags    = Flags;
+    mMaxOutstanding = tMaxOutstanding;
+    mMaxPayload     = tMaxPayload;
+    mMaxQueuedBytes = tMaxQueuedBytes;
+
+    {
+        std::lock_guard <std::mutex> Lock(mMutex);
+        mRunning = true;
+    }
+
+    mReceiver = std::thread(&dSocketRpcClient::receive, this);
+
+    return dSocketResult::SUCCESS;
+}
+/**
+ * Function for stopping the receiver thread. Requests still waiting for a response are
+ * completed with CONNECTION_CLOSED, requests not sent yet are dropped and the socket gets
+ * its original file status flags back (it is left open). Called from a callback it only
+ * makes the receiver thread exit; the rest is done by the next stop, start or the destructor
+ */
+void dSocketRpcClient::stop() {
+    if (!mReceiver.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard <std::mutex> Lock(mMutex);
+        mRunning = false;
+    }
+
+    wake();
+
+    if (std::this_thread::get_id() == mReceiver.get_id()) {
+        return;
+    }
+
+    mReceiver.join();
+
+    fail(dSocketResult::CONNECTION_CLOSED);
+
+    //---No call can enqueue any more: they check mRunning and enqueue under the same lock---//
+
+    mQueue.clear();
+    mQueuedBytes.store(0, std::memory_order_relaxed);
+
+    fcntl(mSocket -> getNativeHandle(), F_SETFL, mSocketFlags);
+
+    ::close(mWakeDescriptor);
+    mWakeDescriptor = -1;
+}
+//-----------------------------//
+/**
+ * Function for queueing a request without waiting for it to be sent or answered, never
+ * blocks (so it may be called from a callback). If the request was accepted, the callback is
+ * called exactly once from the receiver thread
+ * @param tSrcBuffer Request payload (copied)
+ * @param tBufferSize Request payload size
+ * @param tTimeoutMs Time to wait for the response, 0 waits until the connection is closed
+ * @param tCallback Function to call with the response
+ * @return Status (TOO_MANY_REQUESTS if the outstanding request or queued byte limit is reached)
+ */
+dSocketResult dSocketRpcClient::call(const uint8_t* tSrcBuffer, size_t tBufferSize, uint32_t tTimeoutMs, Callback tCallback) {
+    if (tBufferSize > UINT32_MAX) {
+        return reportError(dSocketResult::WRITE_ERROR, EMSGSIZE);
+    }
+
+    uint64_t RequestId;
+    size_t Bytes = RpcHeaderSize + tBufferSize;
+    bool NewEarliest = false;
+    bool WasEmpty;
+
+    {
+        std::lock_guard <std::mutex> Lock(mMutex);
+
+        if (!mRunning) {
+            return reportError(dSocketResult::CONNECTION_CLOSED);
+        }
+
+        if (mRequests.size() >= mMaxOutstanding) {
+            return reportError(dSocketResult::TOO_MANY_REQUESTS);
+        }
+
+        //---The receiver only ever lowers the count, so the check cannot be overtaken---//
+
+        if (mQueuedBytes.load(std::memory_order_relaxed) + Bytes > mMaxQueuedBytes) {
+            return reportError(dSocketResult::TOO_MANY_REQUESTS, ENOBUFS);
+        }
+
+        mQueuedBytes.fetch_add(Bytes, std::memory_order_relaxed);
+
+        RequestId = mNextId++;
+
+        Request& Entry = mRequests[RequestId];
+        Entry.Handler = std::move(tCallback);
+
+        if (tTimeoutMs > 0) {
+            Entry.Deadline      = mDeadlines.emplace(Clock::now() + std::chrono::milliseconds(tTimeoutMs), RequestId);
+            Entry.HasDeadline   = true;
+
+            NewEarliest = Entry.Deadline == mDeadlines.begin();
+        }
+
+        uint8_t Header[RpcHeaderSize];
+        encodeHeader(Header, RequestId, static_cast <uint32_t>(tBufferSize), 0);
+
+        iovec Parts[2] {
+                { .iov_base = Header, .iov_len = RpcHeaderSize },
+                { .iov_base = const_cast <uint8_t*>(tSrcBuffer), .iov_len = tBufferSize }
+        };
+
+        //---Under the lock, so stop never leaves a request behind in the queue---//
+
+        WasEmpty = mQueue.enqueue(Parts, 2);
+    }
+
+    //---The receiver has to start polling for POLLOUT, or may be sleeping past the new deadline---//
+
+    if (WasEmpty || NewEarliest) {
+        wake();
+    }
+
+    return dSocketResult::SUCCESS;
+}
+/**
+ * Function for sending a request and getting a future for the response
+ * @param tSrcBuffer Request payload (copied)
+ * @param tBufferSize Request payload size
+ * @param tTimeoutMs Time to wait for the response, 0 waits until the connection is closed
+ * @param tFuture Future to set (left untouched if the request was not accepted)
+ * @return Status (TOO_MANY_REQUESTS if the outstanding request limit is reached)
+ */
+dSocketResult dSocketRpcClient::call(const uint8_t* tSrcBuffer, size_t tBufferSize, uint32_t tTimeoutMs, std::future <dSocketRpcResponse>* tFuture) {
+    auto Promise = std::make_shared <std::promise <dSocketRpcResponse>>();
+    auto Future = Promise -> get_future();
+
+    dSocketResult Result = call(tSrcBuffer, tBufferSize, tTimeoutMs, [Promise](dSocketRpcResponse&& tResponse) {
+        Promise -> set_value(std::move(tResponse));
+    });
+
+    if (Result == dSocketResult::SUCCESS) {
+        *tFuture = std::move(Future);
+    }
+
+    return Result;
+}
+//-----------------------------//
+/**
+ * Function returns the number of requests waiting for a response
+ * @return Request count
+ */
+size_t dSocketRpcClient::getOutstandingCount() const {
+    std::lock_guard <std::mutex> Lock(mMutex);
+    return mRequests.size();
+}
+/**
+ * Function returns the latest failure of this client
+ * @return Failure record (Result is SUCCESS if nothing failed)
+ */
+dSocketError dSocketRpcClient::getLastErrorInfo() const {
+    return dSocketError::unpack(mLastError.load(std::memory_order_relaxed));
+}
+//-----------------------------//
+void dSocketRpcClient::receive() {
+    std::vector <uint8_t> Buffer(RpcReadChunk);
+    size_t Begin = 0;
+    size_t End = 0;
+
+    pollfd Descriptors[2] {
+            { .fd = mSocket -> getNativeHandle(), .events = POLLIN, .revents = 0 },
+            { .fd = mWakeDescriptor, .events = POLLIN, .revents = 0 }
+    };
+
+    dSocketResult Reason = dSocketResult::CONNECTION_CLOSED;
+
+    while (true) {
+        {
+            std::lock_guard <std::mutex> Lock(mMutex);
+
+            if (!mRunning) {
+                break;
+            }
+        }
+
+        //---Send what the callers queued, wait for POLLOUT while the socket is full---//
+
+        if (!flush()) {
+            break;
+        }
+
+        Descriptors[0].events = mQueue.isEmpty() ? POLLIN : POLLIN | POLLOUT;
+
+        if (poll(Descriptors, 2, getPollTimeout()) == -1 && errno != EINTR) {
+            reportError(dSocketResult::READ_ERROR, errno);
+            break;
+        }
+
+        if (Descriptors[1].revents & POLLIN) {
+            uint64_t Counter;
+            [[maybe_unused]] auto Unused = ::read(mWakeDescriptor, &Counter, sizeof(Counter));
+        }
+
+        if (Descriptors[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+            //---Make room for at least one chunk---//
+
+            if (Begin > 0 && Buffer.size() - End < RpcReadChunk) {
+                std::memmove(Buffer.data(), Buffer.data() + Begin, End - Begin);
+                End -= Begin;
+                Begin = 0;
+            }
+
+            if (Buffer.size() - End < RpcReadChunk) {
+                Buffer.resize(End + RpcReadChunk);
+            }
+
+            ssize_t ReadBytes;
+            dSocketError Error;
+
+            if (mSocket -> readTCP(Buffer.data() + End, Buffer.size() - End, &ReadBytes, &Error) != dSocketResult::SUCCESS) {
+                int Errno = Error.Errno;
+
+                if (Errno == EAGAIN || Errno == EWOULDBLOCK || Errno == EINTR) {
+                    continue;
+                }
+
+                reportError(dSocketResult::READ_ERROR, Errno);
+                break;
+            }
+
+            if (ReadBytes == 0) {
+                break;
+            }
+
+            End += ReadBytes;
+
+            //---Complete every whole frame---//
+
+            while (End - Begin >= RpcHeaderSize) {
+                uint64_t RequestId;
+                uint32_t Length;
+                uint32_t Status;
+
+                decodeHeader(Buffer.data() + Begin, &RequestId, &Length, &Status);
+
+                if (Length > mMaxPayload) {
+                    Reason = reportError(dSocketResult::PROTOCOL_ERROR, EMSGSIZE);
+                    break;
+                }
+
+                if (End - Begin < RpcHeaderSize + Length) {
+                    break;
+                }
+
+                complete(RequestId, Status, Buffer.data() + Begin + RpcHeaderSize, Length);
+                Begin += RpcHeaderSize + Length;
+            }
+
+            if (Reason == dSocketResult::PROTOCOL_ERROR) {
+                break;
+            }
+
+            if (Begin == End) {
+                Begin = 0;
+                End = 0;
+            }
+        }
+
+        expire();
+    }
+
+    //---No new requests after this point, the ones left will never get a response---//
+
+    {
+        std::lock_guard <std::mutex> Lock(mMutex);
+        mRunning = false;
+    }
+
+    fail(Reason);
+}
+/**
+ * Function for sending as many queued requests as the socket takes without blocking
+ * (receiver thread only)
+ * @return false if the connection failed
+ */
+bool dSocketRpcClient::flush() {
+    if (mQueue.isEmpty()) {
+        return true;
+    }
+
+    ssize_t WrittenBytes;
+    dSocketError Error;
+
+    if (mSocket -> writeQueuedTCP(&mQueue, &WrittenBytes, &Error) != dSocketResult::SUCCESS) {
+        reportError(dSocketResult::WRITE_ERROR, Error.Errno);
+        return false;
+    }
+
+    mQueuedBytes.fetch_sub(static_cast <size_t>(WrittenBytes), std::memory_order_relaxed);
+
+    return true;
+}
+void dSocketRpcClient::wake() {
+    uint64_t Counter = 1;
+    [[maybe_unused]] auto Unused = ::write(mWakeDescriptor, &Counter, sizeof(Counter));
+}
+//-----------------------------//
+void dSocketRpcClient::complete(uint64_t tRequestId, uint32_t tStatus, const uint8_t* tPayload, size_t tPayloadSize) {
+    Callback Handler;
+
+    {
+        std::lock_guard <std::mutex> Lock(mMutex);
+
+        auto Entry = mRequests.find(tRequestId);
+
+        if (Entry == mRequests.end()) {         //---Already timed out---//
+            return;
+        }
+
+        if (Entry -> second.HasDeadline) {
+            mDeadlines.erase(Entry -> second.Deadline);
+        }
+
+        Handler = std::move(Entry -> second.Handler);
+        mRequests.erase(Entry);
+    }
+
+    dSocketRpcResponse Response;
+
+    Response.Status = tStatus;
+    Response.Payload.assign(tPayload, tPayload + tPayloadSize);
+
+    Handler(std::move(Response));
+}
+void dSocketRpcClient::expire() {
+    std::vector <Callback> Expired;
+
+    {
+        std::lock_guard <std::mutex> Lock(mMutex);
+
+        auto Now = Clock::now();
+
+        while (!mDeadlines.empty() && mDeadlines.begin() -> first <= Now) {
+            auto Entry = mRequests.find(mDeadlines.begin() -> second);
+
+            Expired.push_back(std::move(Entry -> second.Handler));
+
+            mRequests.erase(Entry);
+            mDeadlines.erase(mDeadlines.begin());
+        }
+    }
+
+    for (auto& Handler : Expired) {
+        dSocketRpcResponse Response;
+        Response.Result = dSocketResult::REQUEST_TIMEOUT;
+
+        Handler(std::move(Response));
+    }
+}
+void dSocketRpcClient::fail(dSocketResult tResult) {
+    std::unordered_map <uint64_t, Request> Failed;
+
+    {
+        std::lock_guard <std::mutex> Lock(mMutex);
+
+        Failed.swap(mRequests);
+        mDeadlines.clear();
+    }
+
+    for (auto& Entry : Failed) {
+        dSocketRpcResponse Response;
+        Response.Result = tResult;
+
+        Entry.second.Handler(std::move(Response));
+    }
+}
+//-----------------------------//
+/**
+ * Function returns how long the receiver may sleep before the earliest deadline
+ * @return Timeout in milliseconds (-1 if there are no deadlines)
+ */
+int dSocketRpcClient::getPollTimeout() {
+    std::lock_guard <std::mutex> Lock(mMutex);
+
+    if (mDeadlines.empty()) {
+        return -1;
+    }
+
+    auto Remaining = std::chrono::ceil <std::chrono::milliseconds>(mDeadlines.begin() -> first - Clock::now()).count();
+
+    return static_cast <int>(std::clamp <decltype(Remaining)>(Remaining, 0, INT32_MAX));
+}
+dSocketResult dSocketRpcClient::reportError(dSocketResult tResult, int tErrno) {
+    dSocketError Error {
+            .Result = tResult,
+            .Operation = dSocketOperation::RPC,
+            .Errno = tErrno
+    };
+
+    mLastError.store(Error.pack(), std::memory_order_relaxed);
+
+    return tResult;
+}
+//-----------------------------//
+/**
+ * Function for serving RPC requests of one client until it disconnects. Works with both
+ * blocking and non-blocking connection sockets
+ * @param tSocket TCP or Unix stream server socket
+ * @param tConnection Client socket
+ * @param tHandler Request handler
+ * @param tMaxPayload Largest accepted request payload, larger ones close the connection
+ * @return Status (SUCCESS if the client disconnected)
+ */
+dSocketResult dSocketRpcServer::serveConnection(dSocket* tSocket, int tConnection, const Handler& tHandler, size_t tMaxPayload) {
+    std::vector <uint8_t> Buffer(RpcReadChunk);
+    std::vector <uint8_t> Response;
+    dSocketSendQueue Queue;
+    size_t Begin = 0;
+    size_t End = 0;
+
+    pollfd Descriptor {
+            .fd = tConnection,
+            .events = POLLIN,
+            .revents = 0
+    };
+
+    while (true) {
+        if (Begin > 0 && Buffer.size() - End < RpcReadChunk) {
+            std::memmove(Buffer.data(), Buffer.data() + Begin, End - Begin);
+            End -= Begin;
+            Begin = 0;
+        }
+
+        if (Buffer.size() - End < RpcReadChunk) {
+            Buffer.resize(End + RpcReadChunk);
+        }
+
+        ssize_t ReadBytes;
+        dSocketError Error;
+
+        if (tSocket -> readTCP(tConnection, Buffer.data() + End, Buffer.size() - End, &ReadBytes, &Error) != dSocketResult::SUCCESS) {
+            int Errno = Error.Errno;
+
+            if (Errno == EAGAIN || Errno == EWOULDBLOCK || Errno == EINTR) {
+                poll(&Descriptor, 1, -1);
+                continue;
+            }
+
+            return dSocketResult::READ_ERROR;
+        }
+
+        if (ReadBytes == 0) {
+            return dSocketResult::SUCCESS;
+        }
+
+        End += ReadBytes;
+
+        //---Handle every whole request, then send all responses at once---//
+
+        while (End - Begin >= RpcHeaderSize) {
+            uint64_t RequestId;
+            uint32_t Length;
+            uint32_t Status;
+
+            decodeHeader(Buffer.data() + Begin, &RequestId, &Length, &Status);
+
+            if (Length > tMaxPayload) {
+                return dSocketResult::PROTOCOL_ERROR;
+            }
+
+            if (End - Begin < RpcHeaderSize + Length) {
+                break;
+            }
+
+            Response.clear();
+            Status = tHandler(Buffer.data() + Begin + RpcHeaderSize, Length, &Response);
+
+            uint8_t Header[RpcHeaderSize];
+            encodeHeader(Header, RequestId, static_cast <uint32_t>(Response.size()), Status);
+
+            iovec Parts[2] {
+                    { .iov_base = Header, .iov_len = RpcHeaderSize },
+                    { .iov_base = Response.data(), .iov_len = Response.size() }
+            };
+
+            Queue.enqueue(Parts, 2);
+            Begin += RpcHeaderSize + Length;
+        }
+
+        if (Begin == End) {
+            Begin = 0;
+            End = 0;
+        }
+
+        while (!Queue.isEmpty()) {
+            ssize_t WrittenBytes;
+
+            if (tSocket -> writeQueuedTCP(tConnection, &Queue, &WrittenBytes) != dSocketResult::SUCCESS) {
+                return dSocketResult::WRITE_ERROR;
+            }
+
+            if (!Queue.isEmpty()) {
+                waitWritable(tConnection);
+            }
+        }
+    }
+}
@@ -0,0 +1,130 @@
+//-----------------------------//
+#ifndef DSOCKETRPC_H
+#define DSOCKETRPC_H
+//-----------------------------//
+#include <chrono>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+//-----------------------------//
+#include "dSocket.h"
+#include "dSocketSendQueue.h"
+//-----------------------------//
+/**
+ * Result of one RPC call. Result is SUCCESS if a response arrived, REQUEST_TIMEOUT if it did
+ * not arrive in time, CONNECTION_CLOSED / PROTOCOL_ERROR if the connection was lost before
+ */
+struct dSocketRpcResponse {
+    dSocketResult           Result          = dSocketResult::SUCCESS;
+    uint32_t                Status          = 0;                //---Set by the server handler---//
+    std::vector <uint8_t>   Payload;
+};
+//-----------------------------//
+/**
+ * Pipelined RPC client over a connected TCP or Unix stream client socket. Every request is
+ * framed with a 16-byte header carrying a request ID, so any number of threads can keep many
+ * requests in flight on one connection; responses may arrive in any order and are matched to
+ * their callbacks / futures by ID.
+ *
+ * call never blocks: requests from all threads go to a dSocketSendQueue (bounded in bytes)
+ * and one I/O thread sends them in batches over the non-blocking socket, reads responses,
+ * completes them and expires timed out requests. Callbacks are called on that thread, may
+ * issue new calls and must not block for long
+ */
+class dSocketRpcClient {
+public:
+    using Callback = std::function <void(dSocketRpcResponse&&)>;
+
+    static constexpr size_t DefaultMaxOutstanding   = 4096;
+    static constexpr size_t DefaultMaxPayload       = 16 * 1024 * 1024;
+    static constexpr size_t DefaultMaxQueuedBytes   = 64 * 1024 * 1024;
+
+    //----------//
+
+    dSocketRpcClient() = default;
+    ~dSocketRpcClient();
+
+    dSocketRpcClient(const dSocketRpcClient&) = delete;
+    dSocketRpcClient& operator=(const dSocketRpcClient&) = delete;
+
+    //----------//
+
+    dSocketResult start(dSocket* tSocket, size_t tMaxOutstanding = DefaultMaxOutstanding, size_t tMaxPayload = DefaultMaxPayload,
+                        size_t tMaxQueuedBytes = DefaultMaxQueuedBytes);
+    void stop();
+
+    dSocketResult call(const uint8_t* tSrcBuffer, size_t tBufferSize, uint32_t tTimeoutMs, Callback tCallback);
+    dSocketResult call(const uint8_t* tSrcBuffer, size_t tBufferSize, uint32_t tTimeoutMs, std::future <dSocketRpcResponse>* tFuture);
+
+    [[nodiscard]] size_t getOutstandingCount() const;
+    [[nodiscard]] dSocketError getLastErrorInfo() const;
+private:
+    using Clock     = std::chrono::steady_clock;
+    using Deadlines = std::multimap <Clock::time_point, uint64_t>;
+
+    struct Request {
+        Callback                Handler;
+        Deadlines::iterator     Deadline;
+        bool                    HasDeadline         = false;
+    };
+
+    //----------//
+
+    void receive();
+    bool flush();
+    void wake();
+
+    void complete(uint64_t tRequestId, uint32_t tStatus, const uint8_t* tPayload, size_t tPayloadSize);
+    void expire();
+    void fail(dSocketResult tResult);
+
+    int getPollTimeout();
+
+    dSocketResult reportError(dSocketResult tResult, int tErrno = 0);
+
+    //----------//
+
+    dSocket*                mSocket             = nullptr;
+    int                     mSocketFlags        = 0;        //---File status flags before start---//
+    size_t                  mMaxOutstanding     = DefaultMaxOutstanding;
+    size_t                  mMaxPayload         = DefaultMaxPayload;
+    size_t                  mMaxQueuedBytes     = DefaultMaxQueuedBytes;
+
+    int                     mWakeDescriptor     = -1;
+    std::thread             mReceiver;
+
+    mutable std::mutex                              mMutex;
+    bool                                            mRunning        = false;
+    uint64_t                                        mNextId         = 1;
+    std::unordered_map <uint64_t, Request>          mRequests;
+    Deadlines                                       mDeadlines;
+
+    dSocketSendQueue        mQueue;
+    std::atomic <size_t>    mQueuedBytes        = 0;        //---Request bytes not sent yet---//
+
+    std::atomic <uint64_t>  mLastError          = 0;
+};
+//-----------------------------//
+/**
+ * Server side of the dSocketRpcClient protocol. Requests that arrive together are handled in
+ * order and their responses are sent back in one batch
+ */
+class dSocketRpcServer {
+public:
+    /**
+     * Request handler
+     * @param tRequest Request payload
+     * @param tRequestSize Request payload size
+     * @param tResponse Response payload to fill
+     * @return Status passed to the client
+     */
+    using Handler = std::function <uint32_t(const uint8_t* tRequest, size_t tRequestSize, std::vector <uint8_t>* tResponse)>;
+
+    static dSocketResult serveConnection(dSocket* tSocket, int tConnection, const Handler& tHandler,
+                                         size_t tMaxPayload = dSocketRpcClient::DefaultMaxPayload);
+};
+//-----------------------------//
+#endif
@@ -0,0 +1,170 @@
+//-----------------------------//
+#include <cstring>
+#include <new>
+//-----------------------------//
+#include "dSocketSendQueue.h"
+//-----------------------------//
+dSocketSendQueue::~dSocketSendQueue() {
+    Node* Current = mHead;
+
+    while (Current) {
+        Node* Next = Current -> Next.load(std::memory_order_acquire);
+        release(Current);
+        Current = Next;
+    }
+}
+//-----------------------------//
+/**
+ * Function for adding a message to the queue, safe to call from any thread
+ * @param tSrcBuffer Message data (copied)
+ * @param tBufferSize Message size (empty messages are ignored)
+ * @return true if the queue was empty before, so the owning thread may need a wakeup
+ */
+bool dSocketSendQueue::enqueue(const uint8_t* tSrcBuffer, size_t tBufferSize) {
+    if (tBufferSize == 0) {
+        return false;
+    }
+
+    //----------//
+
+    auto* Message = new (::operator new(sizeof(Node) + tBufferSize)) Node;
+
+    Message -> Size = tBufferSize;
+    std::memcpy(Message -> getData(), tSrcBuffer, tBufferSize);
+
+    bool WasEmpty = mPending.fetch_add(1, std::memory_order_acq_rel) == 0;
+
+    Node* Previous = mTail.exchange(Message, std::memory_order_acq_rel);
+    Previous -> Next.store(Message, std::memory_order_release);
+
+    return WasEmpty;
+}
+/**
+ * Function for adding a message gathered from several parts (e.g. a header and a payload) to
+ * the queue, safe to call from any thread. The parts are sent as one message
+ * @param tParts Message parts (copied)
+ * @param tPartCount Number of parts
+ * @return true if the queue was empty before, so the owning thread may need a wakeup
+ */
+bool dSocketSendQueue::enqueue(const iovec* tParts, int tPartCount) {
+    size_t TotalSize = 0;
+
+    for (int i = 0; i < tPartCount; i++) {
+        TotalSize += tParts[i].iov_len;
+    }
+
+    if (TotalSize == 0) {
+        return false;
+    }
+
+    //----------//
+
+    auto* Message = new (::operator new(sizeof(Node) + TotalSize)) Node;
+    uint8_t* Data = Message -> getData();
+
+    Message -> Size = TotalSize;
+
+    for (int i = 0; i < tPartCount; i++) {
+        std::memcpy(Data, tParts[i].iov_base, tParts[i].iov_len);
+        Data += tParts[i].iov_len;
+    }
+
+    bool WasEmpty = mPending.fetch_add(1, std::memory_order_acq_rel) == 0;
+
+    Node* Previous = mTail.exchange(Message, std::memory_order_acq_rel);
+    Previous -> Next.store(Message, std::memory_order_release);
+
+    return WasEmpty;
+}
+//-----------------------------//
+/**
+ * Function checks whether there are messages that are not completely sent
+ * @return true if there are none
+ */
+bool dSocketSendQueue::isEmpty() const {
+    return mPending.load(std::memory_order_acquire) == 0;
+}
+/**
+ * Function returns the number of messages that are not completely sent
+ * @return Message count
+ */
+size_t dSocketSendQueue::getPendingCount() const {
+    return mPending.load(std::memory_order_acquire);
+}
+//-----------------------------//
+/**
+ * Function for filling an I/O vector with the queued messages (consumer only). The first
+ * entry skips the part of the message that was already sent
+ * @param tVector Vector to fill
+ * @param tMaxCount Vector capacity
+ * @return Number of filled entries
+ */
+int dSocketSendQueue::collect(iovec* tVector, int tMaxCount) {
+    Node* Current = mHead -> Next.load(std::memory_order_acquire);
+    size_t Offset = mOffset;
+    int Count = 0;
+
+    while (Current && Count < tMaxCount) {
+        tVector[Count].iov_base = Current -> getData() + Offset;
+        tVector[Count].iov_len  = Current -> Size - Offset;
+
+        Offset = 0;
+        Count++;
+
+        Current = Current -> Next.load(std::memory_order_acquire);
+    }
+
+    return Count;
+}
+/**
+ * Function for dropping sent bytes from the front of the queue (consumer only)
+ * @param tBytes Number of sent bytes
+ */
+void dSocketSendQueue::consume(size_t tBytes) {
+    while (tBytes > 0) {
+        Node* Current = mHead -> Next.load(std::memory_order_acquire);
+        size_t Remaining = Current -> Size - mOffset;
+
+        if (tBytes < Remaining) {
+            mOffset += tBytes;
+            return;
+        }
+
+        tBytes -= Remaining;
+        mOffset = 0;
+
+        //---The sent message becomes the new dummy head, the previous one is freed---//
+
+        Node* Previous = mHead;
+        mHead = Current;
+
+        release(Previous);
+        mPending.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+/**
+ * Function for dropping every queued message, including a partially sent one (consumer
+ * only, nobody may enqueue meanwhile)
+ */
+void dSocketSendQueue::clear() {
+    Node* Current;
+
+    while ((Current = mHead -> Next.load(std::memory_order_acquire))) {
+        Node* Previous = mHead;
+        mHead = Current;
+
+        release(Previous);
+        mPending.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    mOffset = 0;
+}
+//-----------------------------//
+void dSocketSendQueue::release(Node* tNode) {
+    if (tNode -> Size == 0) {           //---Stub---//
+        return;
+    }
+
+    tNode -> ~Node();
+    ::operator delete(tNode);
+}
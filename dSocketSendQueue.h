@@ -0,0 +1,61 @@
+//-----------------------------//
+#ifndef DSOCKETSENDQUEUE_H
+#define DSOCKETSENDQUEUE_H
+//-----------------------------//
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+//-----------------------------//
+#include <sys/uio.h>
+//-----------------------------//
+/**
+ * Lock-free multi-producer single-consumer queue of outbound messages for one TCP connection.
+ * Any thread may enqueue; only the thread owning the connection drains the queue with
+ * dSocket::writeQueuedTCP, which sends several messages per writev-style call and keeps
+ * partially sent messages intact, so messages from different threads never interleave
+ */
+class dSocketSendQueue {
+public:
+    dSocketSendQueue() = default;
+    ~dSocketSendQueue();
+
+    dSocketSendQueue(const dSocketSendQueue&) = delete;
+    dSocketSendQueue& operator=(const dSocketSendQueue&) = delete;
+
+    //----------//
+
+    bool enqueue(const uint8_t* tSrcBuffer, size_t tBufferSize);
+    bool enqueue(const iovec* tParts, int tPartCount);
+    void clear();
+
+    [[nodiscard]] bool isEmpty() const;
+    [[nodiscard]] size_t getPendingCount() const;
+private:
+    friend class dSocket;
+
+    struct Node {
+        std::atomic <Node*>     Next            = nullptr;
+        size_t                  Size            = 0;
+
+        uint8_t* getData() { return reinterpret_cast <uint8_t*>(this + 1); }
+    };
+
+    //----------//
+
+    int collect(iovec* tVector, int tMaxCount);
+    void consume(size_t tBytes);
+
+    static void release(Node* tNode);
+
+    //----------//
+
+    Node                    mStub;
+
+    Node*                   mHead           = &mStub;           //---Consumer side, last consumed node---//
+    size_t                  mOffset         = 0;                //---Bytes of the first message already sent---//
+
+    alignas(64) std::atomic <Node*>     mTail       = &mStub;   //---Producer side---//
+    alignas(64) std::atomic <size_t>    mPending    = 0;
+};
+//-----------------------------//
+#endif
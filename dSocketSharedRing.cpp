@@ -0,0 +1,777 @@
+//-----------------------------//
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+//-----------------------------//
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+//-----------------------------//
+#include "dSocketSharedRing.h"
+//-----------------------------//
+constexpr uint64_t  SharedRingMagic     = 0x676E695272536444;
+constexpr uint32_t  SharedRingVersion   = 1;
+constexpr size_t    SharedRingPage      = 4096;
+constexpr int       SharedRingCheckMs   = 100;          //---Longest sleep between peer liveness checks---//
+constexpr uint32_t  SharedRingCheckSpin = 0xFFFF;       //---Busy polling checks every 65536 iterations---//
+//-----------------------------//
+static bool waitFutex(std::atomic <uint32_t>* tWord, uint32_t tExpected, int tTimeoutMs) {
+    timespec Timeout {
+            .tv_sec = tTimeoutMs / 1000,
+            .tv_nsec = (tTimeoutMs % 1000) * 1000000L
+    };
+
+    return syscall(SYS_futex, reinterpret_cast <uint32_t*>(tWord), FUTEX_WAIT, tExpected, &Timeout, nullptr, 0) == 0 || errno != ETIMEDOUT;
+}
+static void wakeFutex(std::atomic <uint32_t>* tWord) {
+    tWord -> fetch_add(1, std::memory_order_release);
+    syscall(SYS_futex, reinterpret_cast <uint32_t*>(tWord), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+}
+/**
+ * Function returns the negotiation deadline (time_point::max() for no timeout)
+ */
+static std::chrono::steady_clock::time_point getDeadline(int tTimeoutMs) {
+    if (tTimeoutMs < 0) {
+        return std::chrono::steady_clock::time_point::max();
+    }
+
+    return std::chrono::steady_clock::now() + std::chrono::milliseconds(tTimeoutMs);
+}
+/**
+ * Function for waiting until the negotiation connection is ready for the given events
+ * @return false if the deadline passed first
+ */
+static bool waitReady(int tSocket, short tEvents, std::chrono::steady_clock::time_point tDeadline) {
+    pollfd Poll {
+            .fd = tSocket,
+            .events = tEvents,
+            .revents = 0
+    };
+
+    while (true) {
+        int TimeoutMs = -1;
+
+        if (tDeadline != std::chrono::steady_clock::time_point::max()) {
+            auto Remaining = std::chrono::ceil <std::chrono::milliseconds>(tDeadline - std::chrono::steady_clock::now()).count();
+            TimeoutMs = static_cast <int>(std::clamp <decltype(Remaining)>(Remaining, 0, INT32_MAX));
+        }
+
+        int Result = poll(&Poll, 1, TimeoutMs);
+
+        if (Result != -1 || errno != EINTR) {
+            return Result != 0;             //---Errors are left to the following read / write---//
+        }
+    }
+}
+static void relaxCpu() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+//-----------------------------//
+dSocketSharedRing::~dSocketSharedRing() {
+    close();
+}
+
+dSocketSharedRing::dSocketSharedRing(dSocketSharedRing&& tOther) noexcept :
+        mMapping(tOther.mMapping),
+        mMappingSize(tOther.mMappingSize),
+        mTx(tOther.mTx),
+        mRx(tOther.mRx),
+        mTxData(tOther.mTxData),
+        mRxData(tOther.mRxData),
+        mMask(tOther.mMask),
+        mSpinCount(tOther.mSpinCount),
+        mTimeoutMs(tOther.mTimeoutMs),
+        mPeerSocket(tOther.mPeerSocket),
+        mLastError(tOther.mLastError) {
+    tOther.mMapping     = nullptr;
+    tOther.mPeerSocket  = -1;
+}
+dSocketSharedRing& dSocketSharedRing::operator=(dSocketSharedRing&& tOther) noexcept {
+    if (this != &tOther) {
+        close();
+
+        mMapping        = tOther.mMapping;
+        mMappingSize    = tOther.mMappingSize;
+        mTx             = tOther.mTx;
+        mRx             = tOther.mRx;
+        mTxData         = tOther.mTxData;
+        mRxData         = tOther.mRxData;
+        mMask           = tOther.mMask;
+        mSpinCount      = tOther.mSpinCount;
+        mTimeoutMs      = tOther.mTimeoutMs;
+        mPeerSocket     = tOther.mPeerSocket;
+        mLastError      = tOther.mLastError;
+
+        tOther.mMapping     = nullptr;
+        tOther.mPeerSocket  = -1;
+    }
+
+    return *this;
+}
+//-----------------------------//
+/**
+ * Function for offering a shared ring to the server this client socket is connected to. The
+ * server must call accept on the same connection
+ * @param tSocket Connected TCP or Unix stream client socket
+ * @param tCapacity Capacity of each direction in bytes (rounded up to a power of two)
+ * @param tRing Ring to set up
+ * @param tTimeoutMs Negotiation timeout (-1 to wait indefinitely)
+ * @return Status (NEGOTIATION_DECLINED if the socket has to be used instead, RECV_TIMEOUT if
+ * the peer did not answer in time)
+ */
+dSocketResult dSocketSharedRing::offer(dSocket* tSocket, size_t tCapacity, dSocketSharedRing* tRing, int tTimeoutMs) {
+    return offerImpl(tSocket, -1, tCapacity, tRing, tTimeoutMs);
+}
+/**
+ * Function for offering a shared ring to the specified client of this server socket. The
+ * client must call accept on the same connection
+ * @param tSocket TCP or Unix stream server socket
+ * @param tConnection Client socket
+ * @param tCapacity Capacity of each direction in bytes (rounded up to a power of two)
+ * @param tRing Ring to set up
+ * @param tTimeoutMs Negotiation timeout (-1 to wait indefinitely)
+ * @return Status (NEGOTIATION_DECLINED if the socket has to be used instead, RECV_TIMEOUT if
+ * the peer did not answer in time)
+ */
+dSocketResult dSocketSharedRing::offer(dSocket* tSocket, int tConnection, size_t tCapacity, dSocketSharedRing* tRing, int tTimeoutMs) {
+    return offerImpl(tSocket, tConnection, tCapacity, tRing, tTimeoutMs);
+}
+
+/**
+ * Function for accepting a shared ring offered by the server this client socket is
+ * connected to
+ * @param tSocket Connected TCP or Unix stream client socket
+ * @param tRing Ring to set up
+ * @param tTimeoutMs Negotiation timeout (-1 to wait indefinitely)
+ * @return Status (NEGOTIATION_DECLINED if the socket has to be used instead, RECV_TIMEOUT if
+ * no offer arrived in time)
+ */
+dSocketResult dSocketSharedRing::accept(dSocket* tSocket, dSocketSharedRing* tRing, int tTimeoutMs) {
+    return acceptImpl(tSocket, -1, tRing, tTimeoutMs);
+}
+/**
+ * Function for accepting a shared ring offered by the specified client of this server socket
+ * @param tSocket TCP or Unix stream server socket
+ * @param tConnection Client socket
+ * @param tRing Ring to set up
+ * @param tTimeoutMs Negotiation timeout (-1 to wait indefinitely)
+ * @return Status (NEGOTIATION_DECLINED if the socket has to be used instead, RECV_TIMEOUT if
+ * no offer arrived in time)
+ */
+dSocketResult dSocketSharedRing::accept(dSocket* tSocket, int tConnection, dSocketSharedRing* tRing, int tTimeoutMs) {
+    return acceptImpl(tSocket, tConnection, tRing, tTimeoutMs);
+}
+//-----------------------------//
+/**
+ * Function for setting how many times read / write poll the ring before going to sleep on
+ * the futex. UINT32_MAX never sleeps (pure busy polling, lowest latency)
+ * @param tSpinCount Number of polling iterations
+ */
+void dSocketSharedRing::setBusyPoll(uint32_t tSpinCount) {
+    mSpinCount = tSpinCount;
+}
+/**
+ * Function for limiting how long read / write wait for the peer. On timeout read returns
+ * RECV_TIMEOUT and write returns WRITE_ERROR with EAGAIN, like a socket with SO_RCVTIMEO /
+ * SO_SNDTIMEO
+ * @param tTimeoutMs Timeout (-1 to wait indefinitely)
+ */
+void dSocketSharedRing::setTimeout(int tTimeoutMs) {
+    mTimeoutMs = tTimeoutMs;
+}
+
+/**
+ * Function for reading data from the ring, blocks until at least one byte is available
+ * @param tDstBuffer Buffer to put data into
+ * @param tBufferSize Buffer size
+ * @param tReadBytes Number of bytes actually received (0 if the peer closed the ring or died)
+ * @return Status
+ */
+dSocketResult dSocketSharedRing::read(uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes) {
+    if (!mMapping) {
+        return reportError(dSocketResult::READ_ERROR, EBADF);
+    }
+
+    //----------//
+
+    uint64_t Tail = mRx -> Tail.load(std::memory_order_relaxed);
+    uint32_t Spin = 0;
+    auto Start = std::chrono::steady_clock::now();
+    bool PeerGone = false;
+
+    while (true) {
+        uint64_t Head = mRx -> Head.load(std::memory_order_acquire);
+
+        if (Head != Tail) {
+            size_t Count    = std::min <uint64_t>(tBufferSize, Head - Tail);
+            size_t Offset   = Tail & mMask;
+            size_t First    = std::min(Count, static_cast <size_t>(mMask + 1 - Offset));
+
+            std::memcpy(tDstBuffer, mRxData + Offset, First);
+            std::memcpy(tDstBuffer + First, mRxData, Count - First);
+
+            mRx -> Tail.store(Tail + Count, std::memory_order_seq_cst);
+
+            if (mRx -> ProducerWaiting.load(std::memory_order_seq_cst)) {
+                wakeFutex(&mRx -> SpaceSequence);
+            }
+
+            *tReadBytes = static_cast <ssize_t>(Count);
+            return dSocketResult::SUCCESS;
+        }
+
+        //---A dead peer cannot write any more, so what is left in the ring is delivered first---//
+
+        if (mRx -> ProducerClosed.load(std::memory_order_acquire) || PeerGone) {
+            if (mRx -> Head.load(std::memory_order_acquire) != Tail) {
+                continue;
+            }
+
+            *tReadBytes = 0;
+            return dSocketResult::SUCCESS;
+        }
+
+        bool Woken = false;
+
+        if (Spin < mSpinCount) {
+            Spin++;
+            relaxCpu();
+
+            if ((Spin & SharedRingCheckSpin) != 0) {
+                continue;
+            }
+        } else {
+            uint32_t Sequence = mRx -> DataSequence.load(std::memory_order_acquire);
+
+            mRx -> ConsumerWaiting.store(1, std::memory_order_seq_cst);
+
+            if (mRx -> Head.load(std::memory_order_seq_cst) == Tail && !mRx -> ProducerClosed.load(std::memory_order_seq_cst)) {
+                Woken = waitFutex(&mRx -> DataSequence, Sequence, getWaitSlice(Start));
+            }
+
+            mRx -> ConsumerWaiting.store(0, std::memory_order_relaxed);
+        }
+
+        if (Woken) {
+            continue;
+        }
+
+        if (!isPeerAlive()) {
+            PeerGone = true;
+        } else if (getWaitSlice(Start) == 0) {
+            return reportError(dSocketResult::RECV_TIMEOUT, EAGAIN);
+        }
+    }
+}
+/**
+ * Function for writing data to the ring, blocks until there is space for at least one byte
+ * @param tSrcBuffer Buffer with the data to send
+ * @param tBufferSize Buffer size
+ * @param tWrittenBytes Number of bytes actually written
+ * @return Status
+ */
+dSocketResult dSocketSharedRing::write(const uint8_t* tSrcBuffer, size_t tBufferSize, ssize_t* tWrittenBytes) {
+    if (!mMapping) {
+        return reportError(dSocketResult::WRITE_ERROR, EBADF);
+    }
+
+    //----------//
+
+    uint64_t Head = mTx -> Head.load(std::memory_order_relaxed);
+    uint32_t Spin = 0;
+    auto Start = std::chrono::steady_clock::now();
+
+    while (true) {
+        if (mTx -> ConsumerClosed.load(std::memory_order_acquire)) {
+            return reportError(dSocketResult::WRITE_ERROR, EPIPE);
+        }
+
+        uint64_t Tail = mTx -> Tail.load(std::memory_order_acquire);
+        uint64_t Free = mMask + 1 - (Head - Tail);
+
+        if (Free > 0 || tBufferSize == 0) {
+            size_t Count    = std::min <uint64_t>(tBufferSize, Free);
+            size_t Offset   = Head & mMask;
+            size_t First    = std::min(Count, static_cast <size_t>(mMask + 1 - Offset));
+
+            std::memcpy(mTxData + Offset, tSrcBuffer, First);
+            std::memcpy(mTxData, tSrcBuffer + First, Count - First);
+
+            mTx -> Head.store(Head + Count, std::memory_order_seq_cst);
+
+            if (mTx -> ConsumerWaiting.load(std::memory_order_seq_cst)) {
+                wakeFutex(&mTx -> DataSequence);
+            }
+
+            *tWrittenBytes = static_cast <ssize_t>(Count);
+            return dSocketResult::SUCCESS;
+        }
+
+        bool Woken = false;
+
+        if (Spin < mSpinCount) {
+            Spin++;
+            relaxCpu();
+
+            if ((Spin & SharedRingCheckSpin) != 0) {
+                continue;
+            }
+        } else {
+            uint32_t Sequence = mTx -> SpaceSequence.load(std::memory_order_acquire);
+
+            mTx -> ProducerWaiting.store(1, std::memory_order_seq_cst);
+
+            if (mTx -> Tail.load(std::memory_order_seq_cst) == Tail && !mTx -> ConsumerClosed.load(std::memory_order_seq_cst)) {
+                Woken = waitFutex(&mTx -> SpaceSequence, Sequence, getWaitSlice(Start));
+            }
+
+            mTx -> ProducerWaiting.store(0, std::memory_order_relaxed);
+        }
+
+        if (Woken) {
+            continue;
+        }
+
+        if (!isPeerAlive()) {
+            return reportError(dSocketResult::WRITE_ERROR, EPIPE);
+        }
+
+        if (getWaitSlice(Start) == 0) {
+            return reportError(dSocketResult::WRITE_ERROR, EAGAIN);
+        }
+    }
+}
+
+/**
+ * Function for closing both directions. The peer reads the remaining data and then gets 0
+ * bytes, its writes fail
+ */
+void dSocketSharedRing::close() {
+    if (!mMapping) {
+        return;
+    }
+
+    mTx -> ProducerClosed.store(1, std::memory_order_seq_cst);
+    mRx -> ConsumerClosed.store(1, std::memory_order_seq_cst);
+
+    wakeFutex(&mTx -> DataSequence);
+    wakeFutex(&mRx -> SpaceSequence);
+
+    unmap();
+
+    if (mPeerSocket >= 0) {
+        ::close(mPeerSocket);
+    }
+
+    mPeerSocket = -1;
+}
+//-----------------------------//
+dSocketResult dSocketSharedRing::offerImpl(dSocket* tSocket, int tConnection, size_t tCapacity, dSocketSharedRing* tRing, int tTimeoutMs) {
+    dSocketProtocol Protocol = tSocket -> getProtocol();
+
+    if (Protocol != dSocketProtocol::TCP && Protocol != dSocketProtocol::UNIX_STREAM) {
+        return tRing -> reportError(dSocketResult::WRONG_PROTOCOL);
+    }
+
+    //----------//
+
+    bool Unix = Protocol == dSocketProtocol::UNIX_STREAM;
+    auto Deadline = getDeadline(tTimeoutMs);
+    size_t Capacity = SharedRingPage;
+
+    while (Capacity < tCapacity) {
+        Capacity <<= 1;
+    }
+
+    Offer Message = {};
+
+    Message.Magic       = static_cast <uint32_t>(SharedRingMagic);
+    Message.Version     = SharedRingVersion;
+    Message.Nonce       = (static_cast <uint64_t>(std::random_device()()) << 32) | std::random_device()();
+    Message.Capacity    = Capacity;
+
+    //---Over TCP the peer can only reach a named segment, over Unix the descriptor is passed---//
+
+    int Descriptor;
+
+    if (Unix) {
+        Descriptor = memfd_create("dSocketSharedRing", MFD_CLOEXEC);
+    } else {
+        snprintf(Message.Name, sizeof(Message.Name), "/dSocketRing-%d-%016llx", getpid(), static_cast <unsigned long long>(Message.Nonce));
+        Descriptor = shm_open(Message.Name, O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+    }
+
+    //---On a local failure an empty offer is still sent so that the peer does not hang---//
+
+    if (Descriptor < 0) {
+        tRing -> reportError(dSocketResult::CREATE_FAILURE, errno);
+        Message.Capacity = 0;
+    } else if (tRing -> map(Descriptor, Capacity, true, Message.Nonce, 0) != dSocketResult::SUCCESS) {
+        Message.Capacity = 0;
+    }
+
+    dSocketResult Result;
+    dSocketError Error;
+    ssize_t WrittenBytes = 0;
+
+    if (Unix && Message.Capacity != 0) {
+        if (tConnection < 0) {
+            Result = tSocket -> writeDescriptors(reinterpret_cast <const uint8_t*>(&Message), sizeof(Message), &Descriptor, 1, &WrittenBytes, &Error);
+        } else {
+            Result = tSocket -> writeDescriptors(tConnection, reinterpret_cast <const uint8_t*>(&Message), sizeof(Message), &Descriptor, 1, &WrittenBytes, &Error);
+        }
+
+        if (Result == dSocketResult::SUCCESS && WrittenBytes < static_cast <ssize_t>(sizeof(Message))) {
+            Result = writeExact(tSocket, tConnection, reinterpret_cast <const uint8_t*>(&Message) + WrittenBytes, sizeof(Message) - WrittenBytes, Deadline, &Error);
+        }
+    } else {
+        Result = writeExact(tSocket, tConnection, reinterpret_cast <const uint8_t*>(&Message), sizeof(Message), Deadline, &Error);
+    }
+
+    if (Descriptor >= 0) {
+        ::close(Descriptor);
+    }
+
+    uint8_t Reply = 0;
+
+    if (Result == dSocketResult::SUCCESS) {
+        Result = readExact(tSocket, tConnection, &Reply, sizeof(Reply), Deadline, &Error);
+    }
+
+    if (!Unix && Descriptor >= 0) {
+        shm_unlink(Message.Name);
+    }
+
+    if (Result != dSocketResult::SUCCESS) {
+        tRing -> unmap();
+        return tRing -> reportError(Result, Error.Errno);
+    }
+
+    if (Reply != 1 || Message.Capacity == 0) {
+        tRing -> unmap();
+        return dSocketResult::NEGOTIATION_DECLINED;
+    }
+
+    return tRing -> watchPeer(tConnection < 0 ? tSocket -> getNativeHandle() : tConnection);
+}
+dSocketResult dSocketSharedRing::acceptImpl(dSocket* tSocket, int tConnection, dSocketSharedRing* tRing, int tTimeoutMs) {
+    dSocketProtocol Protocol = tSocket -> getProtocol();
+
+    if (Protocol != dSocketProtocol::TCP && Protocol != dSocketProtocol::UNIX_STREAM) {
+        return tRing -> reportError(dSocketResult::WRONG_PROTOCOL);
+    }
+
+    //----------//
+
+    bool Unix = Protocol == dSocketProtocol::UNIX_STREAM;
+    auto Deadline = getDeadline(tTimeoutMs);
+
+    Offer Message = {};
+    auto* Buffer = reinterpret_cast <uint8_t*>(&Message);
+    int Descriptor = -1;
+    dSocketResult Result;
+    dSocketError Error;
+
+    if (Unix) {
+        ssize_t ReadBytes = 0;
+        size_t Count;
+
+        while (true) {
+            Count = 1;
+
+            if (!waitReady(tConnection < 0 ? tSocket -> getNativeHandle() : tConnection, POLLIN, Deadline)) {
+                Result = dSocketResult::RECV_TIMEOUT;
+                Error.Errno = ETIMEDOUT;
+                break;
+            }
+
+            if (tConnection < 0) {
+                Result = tSocket -> readDescriptors(Buffer, sizeof(Message), &ReadBytes, &Descriptor, &Count, &Error);
+            } else {
+                Result = tSocket -> readDescriptors(tConnection, Buffer, sizeof(Message), &ReadBytes, &Descriptor, &Count, &Error);
+            }
+
+            if (Result == dSocketResult::RECV_TIMEOUT) {
+                continue;
+            }
+
+            break;
+        }
+
+        if (Count == 0) {
+            Descriptor = -1;
+        }
+
+        if (Result == dSocketResult::SUCCESS && ReadBytes == 0) {
+            Result = dSocketResult::READ_ERROR;
+        }
+
+        if (Result == dSocketResult::SUCCESS && ReadBytes < static_cast <ssize_t>(sizeof(Message))) {
+            Result = readExact(tSocket, tConnection, Buffer + ReadBytes, sizeof(Message) - ReadBytes, Deadline, &Error);
+        }
+    } else {
+        Result = readExact(tSocket, tConnection, Buffer, sizeof(Message), Deadline, &Error);
+    }
+
+    if (Result != dSocketResult::SUCCESS) {
+        if (Descriptor >= 0) {
+            ::close(Descriptor);
+        }
+
+        return tRing -> reportError(Result, Error.Errno);
+    }
+
+    //----------//
+
+    uint8_t Reply = 0;
+
+    if (Message.Magic == static_cast <uint32_t>(SharedRingMagic) && Message.Version == SharedRingVersion && Message.Capacity != 0) {
+        if (!Unix) {
+            Message.Name[sizeof(Message.Name) - 1] = '\0';
+            Descriptor = shm_open(Message.Name, O_RDWR | O_CLOEXEC, 0);
+        }
+
+        if (Descriptor >= 0) {
+            Reply = tRing -> map(Descriptor, Message.Capacity, false, Message.Nonce, 1) == dSocketResult::SUCCESS;
+        }
+    }
+
+    if (Descriptor >= 0) {
+        ::close(Descriptor);
+    }
+
+    if ((Result = writeExact(tSocket, tConnection, &Reply, sizeof(Reply), Deadline, &Error)) != dSocketResult::SUCCESS) {
+        tRing -> unmap();
+        return tRing -> reportError(Result, Error.Errno);
+    }
+
+    if (Reply != 1) {
+        return dSocketResult::NEGOTIATION_DECLINED;
+    }
+
+    return tRing -> watchPeer(tConnection < 0 ? tSocket -> getNativeHandle() : tConnection);
+}
+//-----------------------------//
+/**
+ * Function for reading exactly the requested number of bytes from the negotiation connection
+ * before the deadline, blocking or not
+ */
+dSocketResult dSocketSharedRing::readExact(dSocket* tSocket, int tConnection, uint8_t* tDstBuffer, size_t tSize,
+                                           std::chrono::steady_clock::time_point tDeadline, dSocketError* tError) {
+    size_t Done = 0;
+    ssize_t ReadBytes;
+    dSocketResult Result;
+
+    while (Done < tSize) {
+        if (!waitReady(tConnection < 0 ? tSocket -> getNativeHandle() : tConnection, POLLIN, tDeadline)) {
+            tError -> Errno = ETIMEDOUT;
+            return dSocketResult::RECV_TIMEOUT;
+        }
+
+        if (tConnection < 0) {
+            Result = tSocket -> readTCP(tDstBuffer + Done, tSize - Done, &ReadBytes, tError);
+        } else {
+            Result = tSocket -> readTCP(tConnection, tDstBuffer + Done, tSize - Done, &ReadBytes, tError);
+        }
+
+        if (Result != dSocketResult::SUCCESS) {
+            int Errno = tError -> Errno;
+
+            if (Errno == EAGAIN || Errno == EWOULDBLOCK || Errno == EINTR) {
+                continue;
+            }
+
+            return Result;
+        }
+
+        if (ReadBytes == 0) {
+            return dSocketResult::READ_ERROR;
+        }
+
+        Done += ReadBytes;
+    }
+
+    return dSocketResult::SUCCESS;
+}
+/**
+ * Function for writing exactly the requested number of bytes to the negotiation connection
+ * before the deadline, blocking or not
+ */
+dSocketResult dSocketSharedRing::writeExact(dSocket* tSocket, int tConnection, const uint8_t* tSrcBuffer, size_t tSize,
+                                            std::chrono::steady_clock::time_point tDeadline, dSocketError* tError) {
+    size_t Done = 0;
+    ssize_t WrittenBytes;
+    dSocketResult Result;
+
+    while (Done < tSize) {
+        if (!waitReady(tConnection < 0 ? tSocket -> getNativeHandle() : tConnection, POLLOUT, tDeadline)) {
+            tError -> Errno = ETIMEDOUT;
+            return dSocketResult::RECV_TIMEOUT;
+        }
+
+        if (tConnection < 0) {
+            Result = tSocket -> writeTCP(tSrcBuffer + Done, tSize - Done, &WrittenBytes, tError);
+        } else {
+            Result = tSocket -> writeTCP(tConnection, tSrcBuffer + Done, tSize - Done, &WrittenBytes, tError);
+        }
+
+        if (Result != dSocketResult::SUCCESS) {
+            int Errno = tError -> Errno;
+
+            if (Errno == EAGAIN || Errno == EWOULDBLOCK || Errno == EINTR) {
+                continue;
+            }
+
+            return Result;
+        }
+
+        Done += WrittenBytes;
+    }
+
+    return dSocketResult::SUCCESS;
+}
+//-----------------------------//
+/**
+ * Function for keeping a duplicate of the negotiation connection. The kernel hangs it up
+ * when the peer process dies, which is how waiting read / write notice a dead peer
+ * @param tConnection Negotiation connection
+ * @return Status
+ */
+dSocketResult dSocketSharedRing::watchPeer(int tConnection) {
+    int Descriptor;
+
+    if ((Descriptor = fcntl(tConnection, F_DUPFD_CLOEXEC, 0)) == -1) {
+        int Errno = errno;
+        unmap();
+
+        return reportError(dSocketResult::CREATE_FAILURE, Errno);
+    }
+
+    if (mPeerSocket >= 0) {
+        ::close(mPeerSocket);
+    }
+
+    mPeerSocket = Descriptor;
+
+    return dSocketResult::SUCCESS;
+}
+/**
+ * Function checks whether the negotiation connection is still open on the peer side
+ * @return false if the connection was hung up or shut down
+ */
+bool dSocketSharedRing::isPeerAlive() const {
+    pollfd Poll {
+            .fd = mPeerSocket,
+            .events = POLLRDHUP,
+            .revents = 0
+    };
+
+    if (mPeerSocket < 0 || poll(&Poll, 1, 0) <= 0) {
+        return true;
+    }
+
+    return (Poll.revents & (POLLHUP | POLLRDHUP | POLLERR)) == 0;
+}
+/**
+ * Function returns how long the next futex wait may sleep: one liveness check period, cut
+ * to what is left of the timeout
+ * @param tStart Time the wait started
+ * @return Milliseconds (0 once the timeout has expired)
+ */
+int dSocketSharedRing::getWaitSlice(std::chrono::steady_clock::time_point tStart) const {
+    if (mTimeoutMs < 0) {
+        return SharedRingCheckMs;
+    }
+
+    auto Elapsed = std::chrono::duration_cast <std::chrono::milliseconds>(std::chrono::steady_clock::now() - tStart).count();
+
+    return static_cast <int>(std::clamp <int64_t>(mTimeoutMs - Elapsed, 0, SharedRingCheckMs));
+}
+/**
+ * Function for mapping the shared segment. The creating side sizes and initializes it, the
+ * other side verifies that it got the very segment that was offered
+ * @param tDescriptor Segment descriptor
+ * @param tCapacity Capacity of each direction
+ * @param tCreate true for the offering side
+ * @param tNonce Random value identifying the segment
+ * @param tSide 0 for the offering side, 1 for the accepting one
+ * @return Status
+ */
+dSocketResult dSocketSharedRing::map(int tDescriptor, size_t tCapacity, bool tCreate, uint64_t tNonce, int tSide) {
+    size_t HeaderSize = (sizeof(Header) + SharedRingPage - 1) / SharedRingPage * SharedRingPage;
+    size_t Size = HeaderSize + 2 * tCapacity;
+
+    if (tCapacity == 0 || (tCapacity & (tCapacity - 1)) != 0) {
+        return reportError(dSocketResult::CREATE_FAILURE, EINVAL);
+    }
+
+    if (tCreate) {
+        if (ftruncate(tDescriptor, static_cast <off_t>(Size)) == -1) {
+            return reportError(dSocketResult::CREATE_FAILURE, errno);
+        }
+    } else {
+        struct stat Stat = {};
+
+        if (fstat(tDescriptor, &Stat) == -1 || static_cast <size_t>(Stat.st_size) < Size) {
+            return reportError(dSocketResult::CREATE_FAILURE, EINVAL);
+        }
+    }
+
+    void* Address = mmap(nullptr, Size, PROT_READ | PROT_WRITE, MAP_SHARED, tDescriptor, 0);
+
+    if (Address == MAP_FAILED) {
+        return reportError(dSocketResult::CREATE_FAILURE, errno);
+    }
+
+    auto* Mapping = static_cast <Header*>(Address);
+
+    if (tCreate) {
+        Mapping -> Magic        = SharedRingMagic;
+        Mapping -> Nonce        = tNonce;
+        Mapping -> Capacity     = tCapacity;
+    } else if (Mapping -> Magic != SharedRingMagic || Mapping -> Nonce != tNonce || Mapping -> Capacity != tCapacity) {
+        munmap(Address, Size);
+        return reportError(dSocketResult::NEGOTIATION_DECLINED);
+    }
+
+    unmap();
+
+    auto* Data = static_cast <uint8_t*>(Address) + HeaderSize;
+
+    mMapping        = Mapping;
+    mMappingSize    = Size;
+    mTx             = &Mapping -> Rings[tSide];
+    mRx             = &Mapping -> Rings[1 - tSide];
+    mTxData         = Data + tSide * tCapacity;
+    mRxData         = Data + (1 - tSide) * tCapacity;
+    mMask           = tCapacity - 1;
+
+    return dSocketResult::SUCCESS;
+}
+void dSocketSharedRing::unmap() {
+    if (mMapping) {
+        munmap(mMapping, mMappingSize);
+    }
+
+    mMapping    = nullptr;
+    mTx         = nullptr;
+    mRx         = nullptr;
+    mTxData     = nullptr;
+    mRxData     = nullptr;
+}
+//-----------------------------//
+dSocketResult dSocketSharedRing::reportError(dSocketResult tResult, int tErrno) {
+    mLastError = {
+            .Result = tResult,
+            .Operation = dSocketOperation::SHARED_RING,
+            .Errno = tErrno
+    };
+
+    return tResult;
+}
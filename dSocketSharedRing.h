@@ -0,0 +1,126 @@
+//-----------------------------//
+#ifndef DSOCKETSHAREDRING_H
+#define DSOCKETSHAREDRING_H
+//-----------------------------//
+#include <chrono>
+//-----------------------------//
+#include "dSocket.h"
+//-----------------------------//
+/**
+ * Shared-memory transport for peers on the same host. Two lock-free single-producer
+ * single-consumer byte rings (one per direction) live in a memory mapping negotiated over an
+ * existing dSocket stream connection: the mapping descriptor is passed with SCM_RIGHTS over
+ * Unix sockets, over TCP a named segment is offered and verified with a nonce. If the peer
+ * cannot map the segment the offer is declined and both sides keep using the socket. If the
+ * peer does not take part in time (DefaultNegotiationTimeoutMs by default) the negotiation
+ * fails with RECV_TIMEOUT; the connection may then hold part of it and should be closed.
+ *
+ * read / write behave like readTCP / writeTCP on a blocking socket: partial transfers are
+ * possible, read returns 0 bytes once the peer closed its end and the ring is drained.
+ * Waiting is done with a process-shared futex, optionally after busy polling. The ring keeps
+ * a duplicate of the negotiation connection and checks it between bounded waits, so a peer
+ * that died (or shut the connection down) is treated like a closed ring
+ */
+class dSocketSharedRing {
+public:
+    static constexpr int DefaultNegotiationTimeoutMs = 5000;
+
+    //----------//
+
+    dSocketSharedRing() = default;
+    ~dSocketSharedRing();
+
+    dSocketSharedRing(const dSocketSharedRing&) = delete;
+    dSocketSharedRing& operator=(const dSocketSharedRing&) = delete;
+
+    dSocketSharedRing(dSocketSharedRing&& tOther) noexcept;
+    dSocketSharedRing& operator=(dSocketSharedRing&& tOther) noexcept;
+
+    //----------//
+
+    static dSocketResult offer(dSocket* tSocket, size_t tCapacity, dSocketSharedRing* tRing, int tTimeoutMs = DefaultNegotiationTimeoutMs);
+    static dSocketResult offer(dSocket* tSocket, int tConnection, size_t tCapacity, dSocketSharedRing* tRing, int tTimeoutMs = DefaultNegotiationTimeoutMs);
+
+    static dSocketResult accept(dSocket* tSocket, dSocketSharedRing* tRing, int tTimeoutMs = DefaultNegotiationTimeoutMs);
+    static dSocketResult accept(dSocket* tSocket, int tConnection, dSocketSharedRing* tRing, int tTimeoutMs = DefaultNegotiationTimeoutMs);
+
+    //----------//
+
+    void setBusyPoll(uint32_t tSpinCount);
+    void setTimeout(int tTimeoutMs);
+
+    dSocketResult read(uint8_t* tDstBuffer, size_t tBufferSize, ssize_t* tReadBytes);
+    dSocketResult write(const uint8_t* tSrcBuffer, size_t tBufferSize, ssize_t* tWrittenBytes);
+
+    void close();
+
+    [[nodiscard]] bool isValid() const { return mMapping != nullptr; }
+    [[nodiscard]] dSocketError getLastErrorInfo() const { return mLastError; }
+private:
+    struct Ring {
+        alignas(64) std::atomic <uint64_t>  Head;               //---Written by the producer---//
+        alignas(64) std::atomic <uint64_t>  Tail;               //---Written by the consumer---//
+
+        alignas(64) std::atomic <uint32_t>  DataSequence;       //---Futex the consumer sleeps on---//
+        std::atomic <uint32_t>              ConsumerWaiting;
+        std::atomic <uint32_t>              ProducerClosed;
+
+        alignas(64) std::atomic <uint32_t>  SpaceSequence;      //---Futex the producer sleeps on---//
+        std::atomic <uint32_t>              ProducerWaiting;
+        std::atomic <uint32_t>              ConsumerClosed;
+    };
+
+    struct Header {
+        uint64_t            Magic;
+        uint64_t            Nonce;
+        uint64_t            Capacity;
+
+        Ring                Rings[2];
+    };
+
+    struct Offer {
+        uint32_t            Magic;
+        uint32_t            Version;
+        uint64_t            Nonce;
+        uint64_t            Capacity;
+        char                Name[48];
+    };
+
+    //----------//
+
+    static dSocketResult offerImpl(dSocket* tSocket, int tConnection, size_t tCapacity, dSocketSharedRing* tRing, int tTimeoutMs);
+    static dSocketResult acceptImpl(dSocket* tSocket, int tConnection, dSocketSharedRing* tRing, int tTimeoutMs);
+
+    static dSocketResult readExact(dSocket* tSocket, int tConnection, uint8_t* tDstBuffer, size_t tSize,
+                                   std::chrono::steady_clock::time_point tDeadline, dSocketError* tError);
+    static dSocketResult writeExact(dSocket* tSocket, int tConnection, const uint8_t* tSrcBuffer, size_t tSize,
+                                    std::chrono::steady_clock::time_point tDeadline, dSocketError* tError);
+
+    dSocketResult watchPeer(int tConnection);
+    [[nodiscard]] bool isPeerAlive() const;
+    [[nodiscard]] int getWaitSlice(std::chrono::steady_clock::time_point tStart) const;
+
+    dSocketResult map(int tDescriptor, size_t tCapacity, bool tCreate, uint64_t tNonce, int tSide);
+    void unmap();
+
+    dSocketResult reportError(dSocketResult tResult, int tErrno = 0);
+
+    //----------//
+
+    Header*             mMapping        = nullptr;
+    size_t              mMappingSize    = 0;
+
+    Ring*               mTx             = nullptr;
+    Ring*               mRx             = nullptr;
+    uint8_t*            mTxData         = nullptr;
+    uint8_t*            mRxData         = nullptr;
+    uint64_t            mMask           = 0;
+
+    uint32_t            mSpinCount      = 0;
+    int                 mTimeoutMs      = -1;
+    int                 mPeerSocket     = -1;       //---Duplicate of the negotiation connection---//
+
+    dSocketError        mLastError;
+};
+//-----------------------------//
+#endif
@@ -2,6 +2,7 @@
 #include <future>
 //-----------------------------//
 #include "dSocket.h"
+#include "dSocketLogSink.h"
 //-----------------------------//
 
 //-----------------------------//
@@ -23,5 +24,10 @@ int main() {
         auto Result = Client.connectToServer(1000);
     });
 
+    ServerThread.wait();
+    ClientThread.wait();
+
+    dSocketLogSink::instance().flush(std::cerr);
+
     return 0;
 }
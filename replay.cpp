@@ -0,0 +1,503 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <map>
+#include <string>
+#include <thread>
+//-----------------------------//
+#include "dSocket.h"
+#include "dSocketCapture.h"
+//-----------------------------//
+/**
+ * Replays a dSocketCapture file against loopback servers. Every captured socket is a session:
+ * its reads and writes are repeated with the same sizes through a fresh loopback connection,
+ * while a mirror server reads what the session writes and writes what it reads. Writes are
+ * paced by the captured timing scaled by the speed factor, or issued back to back at max speed.
+ *
+ * Usage: dSocketReplay <capture file> [speed factor | max]
+ */
+//-----------------------------//
+using Clock = std::chrono::steady_clock;
+
+constexpr int UdpWaitMs = 1000;                 //---A datagram not arriving in time counts as lost---//
+constexpr int UdpPollMs = 10;                   //---The mirror checks this often whether the client has finished---//
+constexpr int UdpReceiveBuffer = 4 * 1024 * 1024;   //---Back to back replays overrun the default receive buffer---//
+
+struct ReplayStep {
+    uint64_t            Offset;                 //---Nanoseconds since the first record of the session---//
+    uint32_t            Size;
+    bool                Write;
+};
+struct ReplaySession {
+    int32_t             Socket          = -1;
+    bool                Datagram        = false;
+    std::vector <ReplayStep>    Steps;
+};
+struct ReplayReport {
+    bool                Completed       = false;
+    uint64_t            SentBytes       = 0;
+    uint64_t            ReceivedBytes   = 0;
+    uint64_t            Lost            = 0;
+    double              Duration        = 0;    //---Seconds---//
+    std::vector <double>    Latencies;          //---First write of a request to the first byte of its response, microseconds---//
+};
+//-----------------------------//
+static uint32_t PayloadSize = 65536;
+static thread_local std::vector <uint8_t> Payload;
+//-----------------------------//
+static void preparePayload() {
+    Payload.resize(PayloadSize);
+}
+static bool waitReadable(int tSocket, int tTimeoutMs) {
+    pollfd Descriptor {
+            .fd = tSocket,
+            .events = POLLIN,
+            .revents = 0
+    };
+
+    return poll(&Descriptor, 1, tTimeoutMs) > 0;
+}
+/**
+ * Function for waiting for a datagram on the mirror. The wait is cut short once the client
+ * has finished: a datagram that is not queued by then will not arrive any more
+ * @param tSocket - mirror socket
+ * @param tFinished - set by the client after its last step
+ * @return true if a datagram can be read
+ */
+static bool waitDatagram(int tSocket, const std::atomic <bool>& tFinished) {
+    auto Deadline = Clock::now() + std::chrono::milliseconds(UdpWaitMs);
+
+    while (!tFinished.load(std::memory_order_acquire)) {
+        auto Left = std::chrono::duration_cast <std::chrono::milliseconds>(Deadline - Clock::now()).count();
+
+        if (Left <= 0) {
+            return false;
+        }
+
+        if (waitReadable(tSocket, static_cast <int>(std::min <int64_t>(Left, UdpPollMs)))) {
+            return true;
+        }
+    }
+
+    return waitReadable(tSocket, 0);
+}
+static uint16_t getLocalPort(int tSocket) {
+    sockaddr_in Struct = {};
+    socklen_t StructSize = sizeof(Struct);
+
+    getsockname(tSocket, (struct sockaddr*)&Struct, &StructSize);
+
+    return ntohs(Struct.sin_port);
+}
+//-----------------------------//
+/**
+ * Stream helpers: captured reads and writes may be split differently on replay, so they
+ * are repeated as exact byte counts
+ */
+static bool readStream(dSocket* tSocket, int tConnection, size_t tSize) {
+    while (tSize > 0) {
+        ssize_t ReadBytes;
+        dSocketResult Result = tConnection < 0 ?
+                tSocket -> readTCP(Payload.data(), std::min(tSize, Payload.size()), &ReadBytes) :
+                tSocket -> readTCP(tConnection, Payload.data(), std::min(tSize, Payload.size()), &ReadBytes);
+
+        if (Result != dSocketResult::SUCCESS || ReadBytes == 0) {
+            return false;
+        }
+
+        tSize -= ReadBytes;
+    }
+
+    return true;
+}
+static bool writeStream(dSocket* tSocket, int tConnection, size_t tSize) {
+    while (tSize > 0) {
+        ssize_t WrittenBytes;
+        dSocketResult Result = tConnection < 0 ?
+                tSocket -> writeTCP(Payload.data(), std::min(tSize, Payload.size()), &WrittenBytes) :
+                tSocket -> writeTCP(tConnection, Payload.data(), std::min(tSize, Payload.size()), &WrittenBytes);
+
+        if (Result != dSocketResult::SUCCESS) {
+            return false;
+        }
+
+        tSize -= WrittenBytes;
+    }
+
+    return true;
+}
+//-----------------------------//
+/**
+ * Function for splitting a capture into sessions. Descriptors are reused, so a session ends
+ * when its descriptor is accepted / connected again, at the end of its stream or when the
+ * same descriptor starts carrying another protocol
+ */
+static std::vector <ReplaySession> loadSessions(const std::vector <dSocketCaptureRecord>& tRecords) {
+    std::vector <dSocketCaptureRecord> Records(tRecords);
+    std::vector <ReplaySession> Sessions;
+    std::map <int32_t, size_t> Current;             //---Socket -> index of its open session---//
+    std::vector <uint64_t> Starts;
+
+    //---Slots are reserved in nearly, but not exactly, chronological order---//
+
+    std::stable_sort(Records.begin(), Records.end(), [](const dSocketCaptureRecord& tFirst, const dSocketCaptureRecord& tSecond) {
+        return tFirst.Timestamp < tSecond.Timestamp;
+    });
+
+    for (const auto& Record : Records) {
+        //---New connection: whatever the descriptor carried before belongs to another session---//
+
+        if (Record.Operation == dSocketOperation::ACCEPT || Record.Operation == dSocketOperation::CONNECT) {
+            Current.erase(Record.Socket);
+            continue;
+        }
+
+        bool Write      = Record.Operation == dSocketOperation::WRITE_TCP || Record.Operation == dSocketOperation::WRITE_UDP;
+        bool Datagram   = Record.Operation == dSocketOperation::READ_UDP || Record.Operation == dSocketOperation::WRITE_UDP;
+
+        //---End of stream: a later record on the same descriptor is a new connection---//
+
+        if (Record.Size == 0 && !Datagram) {
+            Current.erase(Record.Socket);
+            continue;
+        }
+
+        auto Entry = Current.find(Record.Socket);
+
+        if (Entry == Current.end() || Sessions[Entry -> second].Datagram != Datagram) {
+            Sessions.push_back({
+                    .Socket = Record.Socket,
+                    .Datagram = Datagram,
+                    .Steps = {}
+            });
+            Starts.push_back(Record.Timestamp);
+
+            Entry = Current.insert_or_assign(Record.Socket, Sessions.size() - 1).first;
+        }
+
+        Sessions[Entry -> second].Steps.push_back({
+                .Offset = Record.Timestamp - Starts[Entry -> second],
+                .Size = Record.Size,
+                .Write = Write
+        });
+    }
+
+    return Sessions;
+}
+//-----------------------------//
+/**
+ * Function for playing the captured side of a stream session against its mirror
+ */
+static void replayStreamClient(const ReplaySession& tSession, double tSpeed, uint16_t tPort, const dSocketOptionProfile& tProfile, ReplayReport* tReport) {
+    preparePayload();
+
+    dSocket Client;
+    Client.init(dSocketProtocol::TCP);
+    Client.setOptionProfile(tProfile);
+    Client.finalize(dSocketType::CLIENT, tPort, "127.0.0.1");
+
+    if (Client.connectToServer(5000) != dSocketResult::SUCCESS) {
+        return;
+    }
+
+    //----------//
+
+    auto Start = Clock::now();
+    std::optional <Clock::time_point> RequestStart;
+
+    tReport -> Completed = true;
+
+    for (const auto& Step : tSession.Steps) {
+        if (Step.Write) {
+            if (tSpeed > 0) {
+                std::this_thread::sleep_until(Start + std::chrono::nanoseconds(static_cast <uint64_t>(Step.Offset / tSpeed)));
+            }
+
+            if (!RequestStart) {
+                RequestStart = Clock::now();
+            }
+
+            if (!writeStream(&Client, -1, Step.Size)) {
+                tReport -> Completed = false;
+                break;
+            }
+
+            tReport -> SentBytes += Step.Size;
+        } else {
+            if (!readStream(&Client, -1, Step.Size)) {
+                tReport -> Completed = false;
+                break;
+            }
+
+            if (RequestStart) {
+                tReport -> Latencies.push_back(std::chrono::duration <double, std::micro>(Clock::now() - *RequestStart).count());
+                RequestStart.reset();
+            }
+
+            tReport -> ReceivedBytes += Step.Size;
+        }
+    }
+
+    tReport -> Duration = std::chrono::duration <double>(Clock::now() - Start).count();
+}
+/**
+ * Function for replaying a stream session: the mirror thread serves one loopback connection,
+ * the calling thread plays the captured side
+ */
+static void replayStream(const ReplaySession& tSession, double tSpeed, ReplayReport* tReport) {
+    dSocketOptionProfile Profile;
+    Profile.NoDelay = true;
+
+    dSocket Server;
+    Server.init(dSocketProtocol::TCP);
+    Server.setOptionProfile(Profile);
+
+    if (Server.finalize(dSocketType::SERVER, 0) != dSocketResult::SUCCESS) {
+        return;
+    }
+
+    uint16_t Port = getLocalPort(Server.getNativeHandle());
+
+    std::thread Mirror([&Server, &tSession] {
+        preparePayload();
+
+        dSocketConnection Connection;
+
+        if (Server.acceptConnection(&Connection, 5000) != dSocketResult::SUCCESS) {
+            return;
+        }
+
+        for (const auto& Step : tSession.Steps) {
+            bool Success = Step.Write ?
+                    readStream(&Server, Connection.getNativeHandle(), Step.Size) :
+                    writeStream(&Server, Connection.getNativeHandle(), Step.Size);
+
+            if (!Success) {
+                return;
+            }
+        }
+
+        //---Wait for the client to finish before closing---//
+
+        readStream(&Server, Connection.getNativeHandle(), 1);
+    });
+
+    //---The client is closed before joining, which lets the mirror finish---//
+
+    replayStreamClient(tSession, tSpeed, Port, Profile, tReport);
+    Mirror.join();
+}
+/**
+ * Function for replaying a datagram session. The session first sends an empty datagram so
+ * the mirror learns its address; datagrams that do not arrive in time on either side are
+ * counted as lost. The mirror stops waiting once the client has finished
+ */
+static void replayDatagram(const ReplaySession& tSession, double tSpeed, ReplayReport* tReport) {
+    dSocketOptionProfile Profile;
+    Profile.ReceiveBuffer = UdpReceiveBuffer;
+
+    dSocket Server;
+    Server.init(dSocketProtocol::UDP);
+    Server.setOptionProfile(Profile);
+
+    if (Server.finalize(dSocketType::SERVER, 0) != dSocketResult::SUCCESS) {
+        return;
+    }
+
+    uint16_t Port = getLocalPort(Server.getNativeHandle());
+
+    std::atomic <bool> Finished = false;
+    uint64_t MirrorLost = 0;
+
+    std::thread Mirror([&Server, &tSession, &Finished, &MirrorLost] {
+        preparePayload();
+
+        sockaddr_in Peer = {};
+        socklen_t PeerSize = sizeof(Peer);
+        ssize_t Bytes;
+
+        if (!waitReadable(Server.getNativeHandle(), 5000) ||
+            Server.readUDP(Payload.data(), Payload.size(), &Bytes, (struct sockaddr*)&Peer, &PeerSize) != dSocketResult::SUCCESS) {
+            return;
+        }
+
+        for (const auto& Step : tSession.Steps) {
+            if (Step.Write) {
+                sockaddr_in Struct = {};
+                socklen_t StructSize = sizeof(Struct);
+
+                if (!waitDatagram(Server.getNativeHandle(), Finished) ||
+                    Server.readUDP(Payload.data(), Payload.size(), &Bytes, (struct sockaddr*)&Struct, &StructSize) != dSocketResult::SUCCESS) {
+                    MirrorLost++;
+                }
+            } else if (!Finished.load(std::memory_order_acquire)) {
+                Server.writeUDP(Payload.data(), Step.Size, &Bytes, (const struct sockaddr*)&Peer, PeerSize);
+            }
+        }
+    });
+
+    preparePayload();
+
+    dSocket Client;
+    Client.init(dSocketProtocol::UDP);
+    Client.setOptionProfile(Profile);
+    Client.finalize(dSocketType::CLIENT, Port, "127.0.0.1");
+
+    //----------//
+
+    ssize_t Bytes;
+
+    Client.writeUDP(Payload.data(), 0, &Bytes);
+
+    auto Start = Clock::now();
+    std::optional <Clock::time_point> RequestStart;
+
+    tReport -> Completed = true;
+
+    for (const auto& Step : tSession.Steps) {
+        if (Step.Write) {
+            if (tSpeed > 0) {
+                std::this_thread::sleep_until(Start + std::chrono::nanoseconds(static_cast <uint64_t>(Step.Offset / tSpeed)));
+            }
+
+            if (!RequestStart) {
+                RequestStart = Clock::now();
+            }
+
+            if (Client.writeUDP(Payload.data(), Step.Size, &Bytes) != dSocketResult::SUCCESS) {
+                tReport -> Completed = false;
+                break;
+            }
+
+            tReport -> SentBytes += Bytes;
+        } else {
+            if (!waitReadable(Client.getNativeHandle(), UdpWaitMs) ||
+                Client.readUDP(Payload.data(), Payload.size(), &Bytes) != dSocketResult::SUCCESS) {
+                tReport -> Lost++;
+                continue;
+            }
+
+            if (RequestStart) {
+                tReport -> Latencies.push_back(std::chrono::duration <double, std::micro>(Clock::now() - *RequestStart).count());
+                RequestStart.reset();
+            }
+
+            tReport -> ReceivedBytes += Bytes;
+        }
+    }
+
+    tReport -> Duration = std::chrono::duration <double>(Clock::now() - Start).count();
+
+    Finished.store(true, std::memory_order_release);
+    Mirror.join();
+
+    tReport -> Lost += MirrorLost;
+}
+//-----------------------------//
+static double getPercentile(std::vector <double>* tValues, double tFraction) {
+    if (tValues -> empty()) {
+        return 0;
+    }
+
+    size_t Index = std::min(tValues -> size() - 1, static_cast <size_t>(tFraction * tValues -> size()));
+    std::nth_element(tValues -> begin(), tValues -> begin() + Index, tValues -> end());
+
+    return (*tValues)[Index];
+}
+static void printReport(const ReplaySession& tSession, ReplayReport* tReport) {
+    double Megabytes = static_cast <double>(tReport -> SentBytes + tReport -> ReceivedBytes) / (1024 * 1024);
+
+    std::cout << "session " << tSession.Socket << (tSession.Datagram ? " UDP" : " TCP")
+              << (tReport -> Completed ? "" : " (incomplete)") << std::fixed << std::setprecision(1)
+              << ": " << tSession.Steps.size() << " ops, sent " << tReport -> SentBytes << " B, received " << tReport -> ReceivedBytes << " B"
+              << ", " << tReport -> Duration * 1000 << " ms, " << (tReport -> Duration > 0 ? Megabytes / tReport -> Duration : 0) << " MB/s";
+
+    if (tSession.Datagram) {
+        std::cout << ", lost " << tReport -> Lost;
+    }
+
+    if (!tReport -> Latencies.empty()) {
+        double Max = *std::max_element(tReport -> Latencies.begin(), tReport -> Latencies.end());
+
+        std::cout << ", latency us p50 " << getPercentile(&tReport -> Latencies, 0.5)
+                  << " p99 " << getPercentile(&tReport -> Latencies, 0.99)
+                  << " max " << Max << " (" << tReport -> Latencies.size() << " samples)";
+    }
+
+    std::cout << std::endl;
+}
+//-----------------------------//
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <capture file> [speed factor | max]" << std::endl;
+        return 1;
+    }
+
+    double Speed = 1;
+
+    if (argc > 2) {
+        Speed = std::strcmp(argv[2], "max") == 0 ? 0 : std::atof(argv[2]);
+
+        if (Speed < 0) {
+            std::cerr << "Invalid speed factor " << argv[2] << std::endl;
+            return 1;
+        }
+    }
+
+    //----------//
+
+    std::vector <dSocketCaptureRecord> Records;
+    uint64_t Dropped = 0;
+
+    if (dSocketCapture::load(argv[1], &Records, &Dropped) != dSocketResult::SUCCESS) {
+        std::cerr << "Cannot load capture " << argv[1] << std::endl;
+        return 1;
+    }
+
+    if (Dropped > 0) {
+        std::cerr << Dropped << " records were dropped during capture, the replay is partial" << std::endl;
+    }
+
+    std::vector <ReplaySession> Sessions = loadSessions(Records);
+    std::vector <ReplayReport> Reports(Sessions.size());
+    uint32_t LargestStep = 65536;
+
+    for (const auto& Session : Sessions) {
+        for (const auto& Step : Session.Steps) {
+            LargestStep = std::max(LargestStep, Step.Size);
+        }
+    }
+
+    PayloadSize = std::min <uint32_t>(LargestStep, 1024 * 1024);
+
+    //---Sessions run concurrently, as they were captured---//
+
+    std::vector <std::thread> Threads;
+    auto Start = Clock::now();
+
+    for (size_t i = 0; i < Sessions.size(); i++) {
+        Threads.emplace_back(Sessions[i].Datagram ? replayDatagram : replayStream, std::cref(Sessions[i]), Speed, &Reports[i]);
+    }
+
+    for (auto& Thread : Threads) {
+        Thread.join();
+    }
+
+    double Duration = std::chrono::duration <double>(Clock::now() - Start).count();
+
+    //----------//
+
+    uint64_t TotalBytes = 0;
+
+    for (size_t i = 0; i < Sessions.size(); i++) {
+        printReport(Sessions[i], &Reports[i]);
+        TotalBytes += Reports[i].SentBytes + Reports[i].ReceivedBytes;
+    }
+
+    std::cout << Sessions.size() << " sessions, " << Records.size() << " records replayed in " << std::fixed << std::setprecision(1)
+              << Duration * 1000 << " ms, " << static_cast <double>(TotalBytes) / (1024 * 1024) / Duration << " MB/s" << std::endl;
+
+    return 0;
+}